@@ -0,0 +1,113 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include "util.h"
+#include "logger.h"
+
+// Benchmark of the worker wait strategies
+// Every strategy runs two phases on its own logger::instance:
+//  burst:  [burst_count] messages as fast as possible (throughput, worker is mostly awake)
+//  paced:  [paced_count] messages with a pause in between (wake-up latency, worker is mostly waiting)
+// Reported are the average cost of a log call on the producer and the end-to-end latency (log call until written into the file)
+//
+// Benchmark of the formatter pool (init_options::formatter_threads)
+// [producer_count] threads log [burst_count] messages in total, reported is the throughput from the first log call until flush() returned
+
+namespace {
+
+    constexpr u32                                           burst_count = 200000;
+    constexpr u32                                           paced_count = 2000;
+    constexpr auto                                          paced_pause = std::chrono::microseconds(200);
+    constexpr u32                                           producer_count = 4;
+
+    struct phase_result {
+        f32                                                 producer_time = 0;          // micro-s per log call
+        logger::stats                                       stats{};
+    };
+
+    phase_result run_phase(const logger::wait_strategy strategy, const std::string& name, const u32 count, const bool paced) {
+
+        logger::instance bench_logger("[$T:$J  $L$X  $I:$G] $C$Z", false, "./logs", "benchmark_" + name + ".log", false, { .worker_wait_strategy = strategy });
+
+        f32 producer_duration = 0;
+        for (u32 x = 0; x < count; x++) {
+
+            f32 call_duration = 0;
+            {
+                util::stopwatch loc_stopwatch(&call_duration, util::duration_precision::microseconds);
+                LOG_TO(bench_logger, Trace, "benchmark message: " << x)
+            }
+            producer_duration += call_duration;
+
+            if (paced) {
+                const auto until = std::chrono::steady_clock::now() + paced_pause;
+                while (std::chrono::steady_clock::now() < until)
+                    std::this_thread::yield();
+            }
+        }
+
+        bench_logger.flush();
+        phase_result result{};
+        result.stats = bench_logger.get_stats();
+        result.producer_time = producer_duration / count;
+        return result;
+    }
+
+    // @return messages per secund
+    f64 run_formatter_phase(const u32 formatter_threads) {
+
+        logger::instance bench_logger("[$T:$J  $L$X  $I:$G] $C$Z", false, "./logs", "benchmark_formatter_" + std::to_string(formatter_threads) + ".log", false, { .formatter_threads = formatter_threads });
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> producers;
+        for (u32 x = 0; x < producer_count; x++)
+            producers.emplace_back([&bench_logger] {
+                for (u32 y = 0; y < burst_count / producer_count; y++)
+                    LOG_TO(bench_logger, Trace, "benchmark message: " << y)
+            });
+
+        for (std::thread& producer : producers)
+            producer.join();
+        bench_logger.flush();
+
+        const f64 duration = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        return burst_count / duration;
+    }
+
+}
+
+int main() {
+
+    const std::pair<logger::wait_strategy, const char*> strategies[] = {
+        { logger::wait_strategy::block,             "block" },
+        { logger::wait_strategy::spin_then_park,    "spin_then_park" },
+        { logger::wait_strategy::yield,             "yield" },
+        { logger::wait_strategy::busy_poll,         "busy_poll" },
+    };
+
+    std::ostringstream report;
+    report << std::left << std::setw(18) << "strategy" << std::setw(8) << "phase" << std::right
+           << std::setw(16) << "producer [us]" << std::setw(18) << "e2e avg [us]" << std::setw(18) << "e2e max [us]" << "\n";
+
+    for (const auto& [strategy, name] : strategies) {
+        for (const bool paced : { false, true }) {
+
+            const phase_result result = run_phase(strategy, std::string(name) + ((paced) ? "_paced" : "_burst"), (paced) ? paced_count : burst_count, paced);
+            report << std::left << std::setw(18) << name << std::setw(8) << ((paced) ? "paced" : "burst") << std::right << std::fixed << std::setprecision(3)
+                   << std::setw(16) << result.producer_time << std::setw(18) << result.stats.average_end_to_end_latency << std::setw(18) << result.stats.max_end_to_end_latency << "\n";
+        }
+    }
+
+    report << "\n" << std::left << std::setw(20) << "formatter threads" << std::right << std::setw(16) << "msgs/s" << "\n";
+    const u32 max_formatter_threads = std::max(std::thread::hardware_concurrency(), 2u);
+    for (u32 formatter_threads = 0; formatter_threads <= max_formatter_threads; formatter_threads = (formatter_threads == 0) ? 1 : formatter_threads * 2)
+        report << std::left << std::setw(20) << formatter_threads << std::right << std::fixed << std::setprecision(0) << std::setw(16) << run_formatter_phase(formatter_threads) << "\n";
+
+    std::cout << "\n" << report.str();
+    return 0;
+}
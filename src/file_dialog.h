@@ -0,0 +1,19 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Optional part of util, needs Qt5 (target cpp_logger_file_dialog). Kept out of util.h so the logger can be used without Qt
+namespace util {
+
+    const std::vector<std::pair<std::string, std::string>> default_filters = {
+        {"All Files", "*.*"},
+        {"C++ Files", "*.cpp *.h *.hpp"},
+        {"Text Files", "*.txt"},
+    };
+    std::filesystem::path file_dialog(const std::string_view title = "Open", const std::vector<std::pair<std::string, std::string>>& filters = default_filters);
+
+}
@@ -0,0 +1,211 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <csignal>
+#include <cerrno>
+#include <algorithm>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "util.h"
+#include "logger.h"
+
+// Minimal collector for the socket sink of the logger (init_options::socket_path), used to test the sink locally
+// Accepts any number of loggers, decodes their frames (see logger::socket_batch_header) and prints every record
+//
+// usage: log_collector <socket_path> [--count <N>] [-o <output_file>]
+//  --count <N>             exit after receiving N records
+//  -o <output_file>        write the records into a file instead of std::cout
+
+namespace {
+
+    volatile std::sig_atomic_t                  stop_requested = 0;
+
+    struct client {
+        int                                     fd = -1;
+        std::string                             buffer{};               // received bytes that are not a complete frame yet
+    };
+
+    struct collector_stats {
+        u64                                     frames = 0;
+        u64                                     records = 0;
+        u64                                     clients = 0;
+    };
+
+    void print_record(std::ostream& output, const logger::socket_record_type type, const std::string_view record) {
+
+        if (type == logger::socket_record_type::formatted) {
+            output << record;
+            return;
+        }
+
+        const std::string_view severity_names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL" };
+        logger::socket_binary_record header{};
+        if (record.size() < sizeof(header))
+            return;
+
+        std::memcpy(&header, record.data(), sizeof(header));
+        const std::string_view content = record.substr(sizeof(header));
+        if (content.size() < static_cast<size_t>(header.file_name_size) + header.function_name_size + header.message_size)
+            return;
+
+        output << "@" << header.timestamp << " #" << header.sequence << " [" << severity_names[std::min<u8>(header.severity, 5)] << "] [" << header.thread_id << "] "
+               << content.substr(0, header.file_name_size) << ":" << header.line << " " << content.substr(header.file_name_size, header.function_name_size) << "() "
+               << content.substr(header.file_name_size + header.function_name_size, header.message_size) << "\n";
+    }
+
+    // decode all complete frames in the buffer of [source], returns false if the stream is corrupt
+    bool process_frames(client& source, std::ostream& output, collector_stats& stats) {
+
+        size_t offset = 0;
+        while (source.buffer.size() - offset >= sizeof(logger::socket_batch_header)) {
+
+            logger::socket_batch_header header{};
+            std::memcpy(&header, source.buffer.data() + offset, sizeof(header));
+            if (header.magic != logger::socket_batch_magic)
+                return false;
+
+            if (source.buffer.size() - offset - sizeof(header) < header.payload_size)
+                break;                                                  // incomplete frame, wait for more data
+
+            const std::string_view payload(source.buffer.data() + offset + sizeof(header), header.payload_size);
+            size_t record_offset = 0;
+            for (u32 x = 0; x < header.record_count && record_offset + sizeof(u32) <= payload.size(); x++) {
+
+                u32 record_size = 0;
+                std::memcpy(&record_size, payload.data() + record_offset, sizeof(u32));
+                record_offset += sizeof(u32);
+                if (record_offset + record_size > payload.size())
+                    return false;
+
+                print_record(output, static_cast<logger::socket_record_type>(header.record_type), payload.substr(record_offset, record_size));
+                record_offset += record_size;
+                stats.records++;
+            }
+
+            stats.frames++;
+            offset += sizeof(header) + header.payload_size;
+        }
+
+        source.buffer.erase(0, offset);
+        return true;
+    }
+
+    void print_usage() {
+
+        std::cerr << "usage: log_collector <socket_path> [--count <N>] [-o <output_file>]" << std::endl;
+    }
+
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    const std::string socket_path = argv[1];
+    u64 max_records = 0;
+    std::string output_path = "";
+    for (int x = 2; x < argc; x++) {
+
+        const std::string_view arg = argv[x];
+        if (arg == "--count" && x + 1 < argc)
+            max_records = std::stoull(argv[++x]);
+        else if (arg == "-o" && x + 1 < argc)
+            output_path = argv[++x];
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    std::ofstream output_file;
+    if (!output_path.empty()) {
+        output_file.open(output_path, std::ios::out | std::ios::binary);
+        if (!output_file.is_open()) {
+            std::cerr << "FAILED to open output file [" << output_path << "]" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = (output_file.is_open()) ? output_file : std::cout;
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "socket path is too long [" << socket_path << "]" << std::endl;
+        return 1;
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(socket_path.c_str());                                            // left over from a previous run
+    if (listener < 0 || bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0) {
+        std::cerr << "FAILED to listen on [" << socket_path << "]: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, [](int) { stop_requested = 1; });
+    std::signal(SIGTERM, [](int) { stop_requested = 1; });
+    std::cerr << "[log_collector] listening on [" << socket_path << "]" << std::endl;
+
+    collector_stats stats{};
+    std::vector<client> clients;
+    std::vector<char> receive_buffer(64 * 1024);
+    while (!stop_requested && (max_records == 0 || stats.records < max_records)) {
+
+        std::vector<pollfd> poll_fds;
+        poll_fds.push_back({ listener, POLLIN, 0 });
+        for (const client& entry : clients)
+            poll_fds.push_back({ entry.fd, POLLIN, 0 });
+
+        if (poll(poll_fds.data(), poll_fds.size(), 200) <= 0)
+            continue;
+
+        if (poll_fds[0].revents & POLLIN) {
+
+            const int new_client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (new_client >= 0) {
+                clients.push_back({ new_client, {} });
+                stats.clients++;
+            }
+        }
+
+        for (size_t x = 1; x < poll_fds.size(); x++) {
+
+            if (poll_fds[x].revents == 0)
+                continue;
+
+            client& source = clients[x - 1];
+            const ssize_t received = recv(source.fd, receive_buffer.data(), receive_buffer.size(), 0);
+            if (received > 0) {
+
+                source.buffer.append(receive_buffer.data(), static_cast<size_t>(received));
+                if (process_frames(source, output, stats))
+                    continue;
+                std::cerr << "[log_collector] corrupt stream, closing connection" << std::endl;
+            }
+
+            close(source.fd);                                               // an incomplete frame of a closed connection is discarded
+            source.fd = -1;
+        }
+
+        std::erase_if(clients, [](const client& entry) { return entry.fd < 0; });
+        output.flush();
+    }
+
+    for (const client& entry : clients)
+        close(entry.fd);
+    close(listener);
+    unlink(socket_path.c_str());
+
+    std::cerr << "[log_collector] received " << stats.records << " records in " << stats.frames << " frames from " << stats.clients << " connections" << std::endl;
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <queue>
+#include <filesystem>
+#include <algorithm>
+
+#include "util.h"
+
+// Merge the per-thread log files (init_options::per_thread_files) into a single view ordered by time
+// Every record in a thread file looks like "@<microseconds since epoch>:<length> <formatted message>",
+// the files are already sorted by time, so a k-way merge only needs one record per file in memory.
+//
+// usage: log_merge <log_dir | thread_file>... [-o <output_file>]
+//  <log_dir>               merges all thread_*.log files inside the directory
+//  -o <output_file>        write the merged view into a file instead of std::cout
+
+namespace {
+
+    struct record_reader {
+
+        // read the next record, returns false at the end of the file or on a malformed record
+        bool next() {
+
+            char at_sign = 0;
+            u64 length = 0;
+            char separator = 0;
+            if (!(file >> at_sign) || at_sign != '@')
+                return false;
+            if (!(file >> timestamp) || file.get() != ':' || !(file >> length) || !file.get(separator) || separator != ' ') {
+                std::cerr << "[log_merge] malformed record in [" << path.string() << "], skipping rest of the file" << std::endl;
+                return false;
+            }
+
+            message.resize(length);
+            if (!file.read(message.data(), static_cast<std::streamsize>(length))) {
+                std::cerr << "[log_merge] truncated record in [" << path.string() << "], skipping rest of the file" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        std::filesystem::path   path;
+        std::ifstream           file;
+        int64                   timestamp = 0;
+        std::string             message = "";
+    };
+
+    void print_usage() {
+
+        std::cerr << "usage: log_merge <log_dir | thread_file>... [-o <output_file>]" << std::endl;
+    }
+
+}
+
+int main(int argc, char** argv) {
+
+    std::vector<std::filesystem::path> paths;
+    std::filesystem::path output_path = "";
+    for (int x = 1; x < argc; x++) {
+
+        const std::string_view arg = argv[x];
+        if (arg == "-o" && x + 1 < argc) {
+            output_path = argv[++x];
+            continue;
+        }
+
+        if (!std::filesystem::is_directory(arg)) {
+            paths.emplace_back(arg);
+            continue;
+        }
+
+        for (const auto& entry : std::filesystem::directory_iterator(arg)) {
+
+            const std::string file_name = entry.path().filename().string();
+            if (entry.is_regular_file() && file_name.rfind("thread_", 0) == 0 && entry.path().extension() == ".log")
+                paths.push_back(entry.path());
+        }
+    }
+
+    if (paths.empty()) {
+        print_usage();
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());                     // deterministic order for records with the same timestamp
+
+    std::ofstream output_file;
+    if (!output_path.empty()) {
+        output_file.open(output_path, std::ios::out | std::ios::binary);
+        if (!output_file.is_open()) {
+            std::cerr << "FAILED to open output file [" << output_path.string() << "]" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = (output_file.is_open()) ? output_file : std::cout;
+
+    std::vector<record_reader> readers(paths.size());
+    auto later = [&readers](const size_t a, const size_t b) {
+        return (readers[a].timestamp != readers[b].timestamp) ? readers[a].timestamp > readers[b].timestamp : a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+
+    for (size_t x = 0; x < paths.size(); x++) {
+
+        readers[x].path = paths[x];
+        readers[x].file.open(paths[x], std::ios::in | std::ios::binary);
+        if (!readers[x].file.is_open()) {
+            std::cerr << "FAILED to open thread file [" << paths[x].string() << "]" << std::endl;
+            continue;
+        }
+        if (readers[x].next())
+            heap.push(x);
+    }
+
+    u64 record_count = 0;
+    while (!heap.empty()) {
+
+        const size_t current = heap.top();
+        heap.pop();
+
+        output << readers[current].message;
+        record_count++;
+
+        if (readers[current].next())
+            heap.push(current);
+    }
+
+    std::cerr << "[log_merge] merged " << record_count << " records from " << paths.size() << " files" << std::endl;
+    return 0;
+}
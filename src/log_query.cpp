@@ -0,0 +1,303 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "util.h"
+#include "logger.h"
+
+// Query a log file written by the logger using its sidecar index (<log_file>.idx)
+// Only blocks whose index entry matches all filters are read, everything else is skipped without touching the disk.
+// Inside a block only the messages whose index record matches are printed. The part of the log file that is not yet covered by
+// the index (the currently open block) has no records, it's only printed if no message filter (--from, --to, --severity, --thread) is used.
+//
+// usage: log_query <log_file> [options]
+//  --from <time>           only messages at or after <time>
+//  --to <time>             only messages at or bevor <time>
+//  --severity <list>       only messages with one of the severities, e.g. Error,Fatal
+//  --thread <lable>        only messages of the thread lable (or thread id), can include a few other threads (64-bit bloom filter)
+//  --grep <text>           only print lines of the selected messages that contain <text>
+//  --blocks                only list the matching blocks, dont print their content
+//
+// <time> is either "yyyy-mm-dd hh:mm[:ss]" or "hh:mm[:ss]" (on the date of the first indexed block)
+
+namespace {
+
+    struct mapped_file {
+
+        ~mapped_file() {
+
+            if (data != nullptr && size > 0)
+                munmap(const_cast<char*>(data), size);
+            if (fd >= 0)
+                close(fd);
+        }
+
+        bool open_file(const std::string& path) {
+
+            fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+
+            struct stat file_stat;
+            if (fstat(fd, &file_stat) != 0)
+                return false;
+
+            size = static_cast<size_t>(file_stat.st_size);
+            if (size == 0)
+                return true;
+
+            void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+                return false;
+
+            data = static_cast<const char*>(mapping);
+            return true;
+        }
+
+        int                 fd = -1;
+        const char*         data = nullptr;
+        size_t              size = 0;
+    };
+
+    struct query {
+
+        // false => every line of a matching block is printed (including other output of the logger)
+        bool filters_messages() const { return from != INT64_MIN || to != INT64_MAX || severity_mask != 0xFF || thread_mask != 0; }
+
+        int64               from = INT64_MIN;
+        int64               to = INT64_MAX;
+        u8                  severity_mask = 0xFF;
+        u64                 thread_mask = 0;            // 0 => all threads
+        std::string         grep{};
+        bool                only_blocks = false;
+    };
+
+    // parse "yyyy-mm-dd hh:mm[:ss]" or "hh:mm[:ss]" into milliseconds since epoch (local time)
+    bool parse_time(const std::string& text, const int64 reference_timestamp, int64& result) {
+
+        std::tm tm{};
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+        if (std::sscanf(text.c_str(), "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) >= 5) {
+
+            tm.tm_year = year - 1900;
+            tm.tm_mon = month - 1;
+            tm.tm_mday = day;
+
+        } else if (std::sscanf(text.c_str(), "%d:%d:%d", &hour, &minute, &second) >= 2) {
+
+            const std::time_t reference = static_cast<std::time_t>(reference_timestamp / 1000);
+            tm = *std::localtime(&reference);
+
+        } else
+            return false;
+
+        tm.tm_hour = hour;
+        tm.tm_min = minute;
+        tm.tm_sec = second;
+        tm.tm_isdst = -1;
+        result = static_cast<int64>(std::mktime(&tm)) * 1000;
+        return true;
+    }
+
+    bool parse_severities(const std::string& text, u8& result) {
+
+        const std::string_view names[] = { "Trace", "Debug", "Info", "Warn", "Error", "Fatal" };
+        result = 0;
+        size_t begin = 0;
+        while (begin <= text.size()) {
+
+            size_t end = text.find(',', begin);
+            if (end == std::string::npos)
+                end = text.size();
+
+            const std::string_view name = std::string_view(text).substr(begin, end - begin);
+            bool found = false;
+            for (u8 x = 0; x < 6; x++)
+                if (strncasecmp(names[x].data(), name.data(), name.size()) == 0 && names[x].size() == name.size()) {
+                    result |= static_cast<u8>(BIT(x));
+                    found = true;
+                }
+
+            if (!found)
+                return false;
+            begin = end + 1;
+        }
+        return true;
+    }
+
+    bool block_matches(const logger::index_entry& entry, const query& q) {
+
+        if (entry.max_timestamp < q.from || entry.min_timestamp > q.to)
+            return false;
+        if ((entry.severity_mask & q.severity_mask) == 0)
+            return false;
+        if (q.thread_mask != 0 && (entry.thread_mask & q.thread_mask) == 0)
+            return false;
+        return true;
+    }
+
+    bool record_matches(const logger::index_entry& entry, const logger::index_record& record, const query& q) {
+
+        const int64 timestamp = entry.min_timestamp + record.time_offset;
+        if (timestamp < q.from || timestamp > q.to)
+            return false;
+        if ((BIT(record.severity) & q.severity_mask) == 0)
+            return false;
+        if (q.thread_mask != 0 && ((u64(1) << record.thread_bit) & q.thread_mask) == 0)
+            return false;
+        return true;
+    }
+
+    void print_range(const mapped_file& log, const u64 begin, const u64 end, const query& q) {
+
+        const u64 clamped_end = std::min<u64>(end, log.size);
+        if (begin >= clamped_end)
+            return;
+
+        const std::string_view range(log.data + begin, clamped_end - begin);
+        if (q.grep.empty()) {
+            std::cout << range;
+            return;
+        }
+
+        size_t line_begin = 0;
+        while (line_begin < range.size()) {
+
+            size_t line_end = range.find('\n', line_begin);
+            line_end = (line_end == std::string_view::npos) ? range.size() : line_end + 1;
+
+            const std::string_view line = range.substr(line_begin, line_end - line_begin);
+            if (line.find(q.grep) != std::string_view::npos)
+                std::cout << line;
+            line_begin = line_end;
+        }
+    }
+
+    // @return number of printed messages
+    size_t print_block(const mapped_file& log, const logger::index_entry& entry, const logger::index_record* records, const query& q) {
+
+        if (!q.filters_messages()) {
+            print_range(log, entry.begin_offset, entry.end_offset, q);
+            return entry.record_count;
+        }
+
+        size_t printed_messages = 0;
+        for (u32 x = 0; x < entry.record_count; x++) {
+
+            if (!record_matches(entry, records[x], q))
+                continue;
+
+            const u64 message_begin = entry.begin_offset + records[x].offset;
+            print_range(log, message_begin, message_begin + records[x].size, q);
+            printed_messages++;
+        }
+        return printed_messages;
+    }
+
+    void print_usage() {
+
+        std::cerr << "usage: log_query <log_file> [--from <time>] [--to <time>] [--severity Error,Fatal] [--thread <lable>] [--grep <text>] [--blocks]\n"
+                  << "       <time> is \"yyyy-mm-dd hh:mm[:ss]\" or \"hh:mm[:ss]\"" << std::endl;
+    }
+
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    const std::string log_path = argv[1];
+    mapped_file log, index;
+    if (!log.open_file(log_path)) {
+        std::cerr << "FAILED to open log file [" << log_path << "]" << std::endl;
+        return 1;
+    }
+    if (!index.open_file(log_path + ".idx") || index.size < sizeof(logger::index_header)) {
+        std::cerr << "FAILED to open index file [" << log_path << ".idx]. Was the logger initialized with [init_options::index_block_size_kb] > 0?" << std::endl;
+        return 1;
+    }
+
+    const logger::index_header* header = reinterpret_cast<const logger::index_header*>(index.data);
+    if (std::memcmp(header->magic, logger::index_magic, sizeof(header->magic)) != 0) {
+        std::cerr << "Invalid index file [" << log_path << ".idx]" << std::endl;
+        return 1;
+    }
+
+    const char* const index_end = index.data + index.size;
+    const char* const first_entry = index.data + sizeof(logger::index_header);
+    const int64 reference_timestamp = (index.size >= sizeof(logger::index_header) + sizeof(logger::index_entry))
+        ? reinterpret_cast<const logger::index_entry*>(first_entry)->min_timestamp : static_cast<int64>(std::time(nullptr)) * 1000;
+
+    query q{};
+    for (int x = 2; x < argc; x++) {
+
+        const std::string_view arg = argv[x];
+        const bool has_value = x + 1 < argc;
+        if (arg == "--from" && has_value) {
+            if (!parse_time(argv[++x], reference_timestamp, q.from)) { print_usage(); return 1; }
+        } else if (arg == "--to" && has_value) {
+            if (!parse_time(argv[++x], reference_timestamp, q.to)) { print_usage(); return 1; }
+            q.to += 999;                                                                    // include the whole secund
+        } else if (arg == "--severity" && has_value) {
+            if (!parse_severities(argv[++x], q.severity_mask)) { print_usage(); return 1; }
+        } else if (arg == "--thread" && has_value)
+            q.thread_mask = logger::index_thread_bit(argv[++x]);
+        else if (arg == "--grep" && has_value)
+            q.grep = argv[++x];
+        else if (arg == "--blocks")
+            q.only_blocks = true;
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    u64 indexed_end = 0;
+    size_t entry_count = 0;
+    size_t matching_blocks = 0;
+    size_t printed_messages = 0;
+    for (const char* position = first_entry; position + sizeof(logger::index_entry) <= index_end; entry_count++) {
+
+        const logger::index_entry& entry = *reinterpret_cast<const logger::index_entry*>(position);
+        const logger::index_record* records = reinterpret_cast<const logger::index_record*>(position + sizeof(logger::index_entry));
+        position += sizeof(logger::index_entry) + entry.record_count * sizeof(logger::index_record);
+        if (position > index_end)
+            break;                                                                          // entry is still being written
+
+        if (entry.end_offset > indexed_end)
+            indexed_end = entry.end_offset;
+
+        if (!block_matches(entry, q))
+            continue;
+
+        matching_blocks++;
+        if (q.only_blocks)
+            std::cout << "block [" << entry_count << "] offset [" << entry.begin_offset << " - " << entry.end_offset << "] time [" << entry.min_timestamp << " - " << entry.max_timestamp
+                      << "] severity_mask [0x" << std::hex << static_cast<u16>(entry.severity_mask) << std::dec << "] messages [" << entry.record_count << "]\n";
+        else
+            printed_messages += print_block(log, entry, records, q);
+    }
+
+    // tail that is not indexed yet (open block or log output after the last batch)
+    const u64 unindexed_bytes = (log.size > indexed_end) ? log.size - indexed_end : 0;
+    const bool print_tail = !q.only_blocks && !q.filters_messages();
+    if (print_tail)
+        print_range(log, indexed_end, log.size, q);
+
+    std::cerr << "[log_query] " << matching_blocks << " of " << entry_count << " indexed blocks matched";
+    if (!q.only_blocks)
+        std::cerr << ", " << printed_messages << " messages printed, " << unindexed_bytes << " unindexed bytes " << ((print_tail) ? "scanned" : "skipped (no index records yet)");
+    std::cerr << std::endl;
+    return 0;
+}
@@ -4,11 +4,22 @@
 #include <condition_variable>
 #include <atomic>
 #include <queue>
+#include <deque>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <string_view>
 #include <cstring>
+#include <cctype>
+#include <charconv>
 #include <fstream>
+#include <vector>
+#include <algorithm>
+#include <bit>
+
+#include <optional>
+#include <future>
+#include <mutex>
 
 #if defined __WIN32__
     #include <Windows.h>
@@ -16,6 +27,38 @@
     #include <time.h>
     #include <sys/time.h>
     #include <ctime>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <cerrno>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <pthread.h>
+#endif
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #include <sys/eventfd.h>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <execinfo.h>
+    #include <dlfcn.h>
+    #include <cxxabi.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define CPU_RELAX()                             __builtin_ia32_pause()
+#elif defined(__aarch64__)
+    #define CPU_RELAX()                             asm volatile("yield")
+#else
+    #define CPU_RELAX()
+#endif
+
+#ifdef LOGGER_USE_ZLIB
+    #include <zlib.h>
+#endif
+#ifdef LOGGER_USE_ZSTD
+    #include <zstd.h>
 #endif
 
 #ifdef BOOST_AVAILABLE
@@ -31,9 +74,6 @@
 
 #define TIME_FORMATTER_PERFORMANCE
 #ifdef TIME_FORMATTER_PERFORMANCE
-    u32 formatting_counter = 0;
-    f32 cumulative_formatting_duration = 0;
-
     #define START_FORMATTING_TIMER                  START_TIMER(formatting)
     #define END_FORMATTING_TIMER                    END_TIMER(formatting)
 #else
@@ -44,9 +84,6 @@
 
 #define TIME_LOGGING_PERFORMANCE
 #ifdef TIME_LOGGING_PERFORMANCE
-    u32 logging_counter = 0;
-    f32 cumulative_logging_duration = 0;
-
     #define START_LOGGONG_TIMER                     START_TIMER(logging)
     #define END_LOGGONG_TIMER                       END_TIMER(logging)
 #else
@@ -57,9 +94,6 @@
 
 #define TIME_COUT_PERFORMANCE
 #ifdef TIME_COUT_PERFORMANCE
-    u32 cout_counter = 0;
-    f32 cumulative_cout_duration = 0;
-
     #define START_COUT_TIMER                        START_TIMER(cout)
     #define END_COUT_TIMER                          END_TIMER(cout)
 #else
@@ -70,9 +104,6 @@
 
 #define TIME_QUEUE_ADDING_PERFORMANCE
 #ifdef TIME_QUEUE_ADDING_PERFORMANCE
-    u32 queue_adding_counter = 0;
-    f32 cumulative_queue_adding_duration = 0;
-
     #define START_QUEUE_ADDING_TIMER                START_TIMER(queue_adding)
     #define END_QUEUE_ADDING_TIMER                  END_TIMER(queue_adding)
 #else
@@ -83,9 +114,6 @@
 
 #define TIME_WRITING_TO_FILE_PERFORMANCE
 #ifdef TIME_WRITING_TO_FILE_PERFORMANCE
-    u32 writing_to_file_counter = 0;
-    f32 cumulative_writing_to_file_duration = 0;
-
     #define START_WRITING_TO_FILE_TIMER             START_TIMER(writing_to_file)
     #define END_WRITING_TO_FILE_TIMER               END_TIMER(writing_to_file)
 #else
@@ -93,6 +121,8 @@
     #define END_WRITING_TO_FILE_TIMER
 #endif
 
+#define TIME_END_TO_END_PERFORMANCE
+
 #ifdef TIME_MAIN_THREAD_PERFORMANCE
     u32 main_thread_counter = 0;
     f32 cumulative_main_thread_duration = 0;
@@ -108,8 +138,6 @@ namespace logger {
 #define SHORT_FILE(text)                                        (strrchr(text, "\\") ? strrchr(text, "\\") + 1 : text)
 #define SHORTEN_FUNC_NAME(text)                                 (strstr(text, "::") ? strstr(text, "::") + 2 : text)
 
-#define LOGGER_UPDATE_FORMAT                                    "LOGGER update format"
-#define LOGGER_REVERSE_FORMAT                                   "LOGGER reverse format"
 
 
 
@@ -122,19 +150,17 @@ namespace logger {
 
 
 
-    // const after init() and bevor shutdown()
-    static bool                                                 is_init = false;
-    static bool                                                 write_logs_to_console = false;
-    static std::filesystem::path                                main_log_dir = "";
-    static std::filesystem::path                                main_log_file_path = "";
-    static std::thread                                          worker_thread;
+    inline const char* get_filename(const char* filepath) {
+
+        const char* filename = std::strrchr(filepath, '\\');
+        if (filename == nullptr)
+            filename = std::strrchr(filepath, '/');
+
+        if (filename == nullptr)
+            return filepath;  // No path separator found, return the whole string
 
-    // thread savety related
-    static std::condition_variable                              cv{};
-    static std::mutex                                           queue_mutex{};                      // only queue related
-    static std::mutex                                           general_mutex{};                    // for everything else
-    // static std::atomic<bool>                                    ready = false;
-    static std::atomic<bool>                                    stop = false;
+        return filename + 1;  // Skip the path separator
+    }
 
     // always const variables
     const std::string_view                                      severity_names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL" };
@@ -148,319 +174,3542 @@ namespace logger {
         "\x1b[41m\x1b[30m",                                         // Fatal: Red Background
     };
 
-    static std::string                                          format_current = "";
-    static std::string                                          format_prev = "";
-    static std::ofstream                                        main_file;
-    static std::unordered_map<std::thread::id, std::string>     thread_lable_map = {};
-    static std::queue<message_format>                           log_queue{};
+    // Runtime log levels from the config file (init_options::config_file). Error & Fatal are always enabled
+    struct level_rules {
 
-    void process_queue();
-    void process_log_message(const message_format&& message);
-    void detach_crash_handler();
+        // priority: thread lable > source file > default
+        bool enabled(const message_format& message, const std::string* thread_lable) const {
 
-    inline const char* get_filename(const char* filepath) {
+            if (message.msg_sev < lowest)
+                return false;
 
-        const char* filename = std::strrchr(filepath, '\\');
-        if (filename == nullptr)
-            filename = std::strrchr(filepath, '/');
+            if (thread_lable != nullptr && !thread_levels.empty()) {
+                const auto thread_level = thread_levels.find(*thread_lable);
+                if (thread_level != thread_levels.end())
+                    return message.msg_sev >= thread_level->second;
+            }
 
-        if (filename == nullptr)
-            return filepath;  // No path separator found, return the whole string
+            if (!file_levels.empty()) {
+                const auto file_level = file_levels.find(get_filename(message.file_name));
+                if (file_level != file_levels.end())
+                    return message.msg_sev >= file_level->second;
+            }
 
-        return filename + 1;  // Skip the path separator
-    }
+            return message.msg_sev >= default_level;
+        }
 
+        severity                                                default_level = severity::Trace;
+        severity                                                lowest = severity::Trace;           // lowest level enabled by any rule, checked on the calling thread
+        std::unordered_map<std::string, severity>               file_levels = {};
+        std::unordered_map<std::string, severity>               thread_levels = {};
+    };
 
-#define OPEN_MAIN_FILE(append)              { if (!main_file.is_open()) {                                                                               \
-                                                main_file = std::ofstream(main_log_file_path, (append) ? std::ios::app : std::ios::out);                \
-                                                if (!main_file.is_open())                                                                               \
-                                                    DEBUG_BREAK("FAILED to open log main_file") } }
+    // Content of the config file, settings that are not in the file keep their current value
+    struct runtime_config {
+        std::optional<std::string>                              format{};
+        std::optional<bool>                                     log_to_console{};
+        std::optional<bool>                                     flush_each_batch{};
+        std::optional<durability>                               durability_mode{};
+        std::optional<u32>                                      fsync_interval_ms{};
+        std::shared_ptr<const level_rules>                      levels{};
+    };
 
-#define CLOSE_MAIN_FILE()                   main_file.close();
+    // Commands for the worker that have to be executed in order with the log messages
+    enum class control_type : u8 {
+        set_format = 0,
+        reverse_format,
+        flush,
+        backtrace,
+    };
 
+    // @param position Sequence number of the next message when the command was enqueued, the worker executes it as soon as no message
+    //                 with a lower sequence number is left in the queue (message_format::sequence)
+    struct control_message {
+        control_type                                            type;
+        u64                                                     position;
+        std::string                                             format{};                           // set_format, line written into the main file for backtrace
+        std::shared_ptr<std::promise<void>>                     barrier{};                          // flush
+    };
 
+    // File of one labeled thread (init_options::per_thread_files), written by the owning thread only
+    struct thread_file {
+        std::mutex                                              mutex{};                            // uncontended, only taken by the owning thread and shutdown()
+        std::ofstream                                           file;
+        std::string                                             lable = "";
+        std::string                                             file_name = "";
+        std::string                                             format = "";                        // copy of [format_current], refreshed when [config_version] changes
+        std::shared_ptr<const level_rules>                      levels{};                           // copy of [levels], refreshed when [config_version] changes
+        u32                                                     config_version = 0;
+        bool                                                    closed = false;
+    };
 
-    // ====================================================================================================================================
-    // init / shutdown
-    // ====================================================================================================================================
+    // Last thread_file lookup of the calling thread, so the hot path doesn't need a lock
+    struct thread_file_cache {
+        u64                                                     instance_id = 0;
+        u32                                                     generation = 0;                     // [thread_files_generation] at the time of the lookup
+        std::shared_ptr<thread_file>                            file{};                             // nullptr if the thread has no own file
+    };
+    static thread_local thread_file_cache                       local_thread_file{};
+    static std::atomic<u64>                                     next_instance_id = 1;
 
-    bool init(const std::string& format, const bool log_to_console, const std::filesystem::path log_dir, const std::string& main_log_file_name, const bool use_append_mode) {
+#if defined __WIN32__
+    static std::atomic<int>                                     current_process_id = static_cast<int>(GetCurrentProcessId());
+#else
+    static std::atomic<int>                                     current_process_id = getpid();     // refreshed in the child after fork()
+#endif
 
-        if (is_init)
-            DEBUG_BREAK("Tryed to init lgging system multiple times")
+    // Last messages below [init_options::backtrace_level], kept unformatted until a trigger
+    struct backtrace_ring {
+        std::deque<message_format>                              messages{};
+        u32                                                     generation = 0;                     // [backtrace_generation] of the instance when the ring was filled
+    };
+    static thread_local std::unordered_map<u64, backtrace_ring> local_backtraces{};                 // rings of the calling thread (backtrace_per_thread), key is the instance_id
 
-        format_current = format;
-        format_prev = format;
-        write_logs_to_console = log_to_console;
+    using lable_map = std::unordered_map<std::thread::id, std::string>;
 
-        if (!std::filesystem::is_directory(log_dir))                            // if not already created
-            if (!std::filesystem::create_directory(log_dir))                    // try to create dir
-                DEBUG_BREAK("FAILED to create directory for log files")
+    // Compresses everything written into [main_file] (init_options::main_file_compression).
+    // Installed as the stream buffer of [main_file], the compressed bytes go into the std::filebuf of the file.
+    // The put area collects the input, it is compressed when full and at every sync() (a sync-flush point)
+    class compressed_streambuf : public std::streambuf {
+    public:
 
-        main_log_dir = log_dir;
-        main_log_file_path = log_dir / main_log_file_name;
+        ~compressed_streambuf() { release(); }
 
-        main_file = std::ofstream(main_log_file_path, (use_append_mode) ? std::ios::app : std::ios::out);
-            if (!main_file.is_open())
-                DEBUG_BREAK("FAILED to open log main_file")
+        // @return the mode that can be used in this build (zstd => gzip => none)
+        static compression supported(const compression mode) {
 
-        if (use_append_mode)
-            main_file << "\n=============================================================================\n";
+#ifdef LOGGER_USE_ZSTD
+            if (mode == compression::zstd)
+                return compression::zstd;
+#endif
+#ifdef LOGGER_USE_ZLIB
+            if (mode != compression::none)
+                return compression::gzip;
+#endif
+            (void)mode;
+            return compression::none;
+        }
 
-        // add some general info to beginning of file
-        auto now = std::time(nullptr);
-        auto tm = *std::localtime(&now);
-        main_file << "Log initialized at [" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "]\n"
-            << "Inital Log Format: '" << format << "' \nEnabled Log Levels: ";
+        // @param level 0 = default of the compressor
+        bool open(const compression mode, std::streambuf* target, const int level) {
 
-        const char* log_sev_strings[] = { "Fatal", " + Error", " + Warn", " + Info", " + Debug", " + Trace"};
-        for (int x = 0; x < LOG_LEVEL_ENABLED +2; x++)
-            main_file << log_sev_strings[x];
-        main_file << "\n=============================================================================\n";
+            release();
+            m_mode = mode;
+            m_level = level;
+            m_target = target;
+            input_bytes = 0;
+            output_bytes = 0;
+            compress_counter = 0;
+            cumulative_compress_duration = 0;
 
-        worker_thread = std::thread(&process_queue);
+            bool success = false;
+#ifdef LOGGER_USE_ZLIB
+            if (mode == compression::gzip) {
 
-        is_init = true;
-        return true;
-    }
+                m_zlib_stream = {};
+                success = deflateInit2(&m_zlib_stream, (level > 0) ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;     // 15 + 16 => gzip header
+            }
+#endif
+#ifdef LOGGER_USE_ZSTD
+            if (mode == compression::zstd) {
 
-    void shutdown() {
+                m_zstd_context = ZSTD_createCCtx();
+                success = m_zstd_context != nullptr && !ZSTD_isError(ZSTD_CCtx_setParameter(m_zstd_context, ZSTD_c_compressionLevel, (level > 0) ? level : 3));
+            }
+#endif
+            (void)level;
+            if (!success) {
 
-        if (!is_init)
-            DEBUG_BREAK("logger::shutdown() was called bevor logger was initalized")
+                release();
+                return false;
+            }
 
-        stop = true;
-        cv.notify_all();
+            m_open = true;
+            m_input.resize(64 * 1024);
+            m_output.resize(64 * 1024);
+            setp(m_input.data(), m_input.data() + m_input.size());
+            return true;
+        }
 
-        if (worker_thread.joinable())
-            worker_thread.join();
+        // compress the rest and write the end of the stream (gzip trailer, zstd epilogue), nothing can be written after this
+        void finish() {
 
-        if (main_file.is_open())
-            CLOSE_MAIN_FILE()
+            if (!m_open)
+                return;
 
-            #ifdef TIME_FORMATTER_PERFORMANCE
-        std::cout << std::left << std::setw(40) << "[LOGGER] Formatting performance:" << " counter [" << std::setw(8) << formatting_counter << "] average time[" << cumulative_formatting_duration / formatting_counter << " micro-s]" << std::endl;
+            compress(flush_mode::finish);
+            m_target->pubsync();
+            release();
+        }
+
+        // forget the stream without writing anything (child after fork(), the stream belongs to the parent)
+        void abandon()                                          { release(); }
+
+        bool is_open() const                                    { return m_open; }
+        compression mode() const                                { return m_mode; }
+        int level() const                                       { return m_level; }
+
+        u64                                                     input_bytes = 0;
+        u64                                                     output_bytes = 0;
+        u32                                                     compress_counter = 0;
+        f32                                                     cumulative_compress_duration = 0;       // micro-s
+        std::atomic<bool>                                       unflushed = false;                      // written since the last sync-flush point
+
+    protected:
+
+        int_type overflow(int_type c) override {
+
+            if (!m_open || !compress(flush_mode::none))
+                return traits_type::eof();
+
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+
+                *pptr() = traits_type::to_char_type(c);
+                pbump(1);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        // sync-flush point, everything written so far can be decompressed
+        int sync() override {
+
+            if (!m_open)
+                return 0;
+
+            if (!compress(flush_mode::sync))
+                return -1;
+            unflushed = false;
+            return m_target->pubsync();
+        }
+
+    private:
+
+        enum class flush_mode : u8 {
+            none = 0,
+            sync,
+            finish,
+        };
+
+        // compress the content of the put area into [m_target]
+        bool compress(const flush_mode flush) {
+
+            const size_t input_size = static_cast<size_t>(pptr() - pbase());
+            if (input_size == 0 && flush == flush_mode::none)
+                return true;
+
+            util::stopwatch loc_stopwatch(&m_compress_duration, util::duration_precision::microseconds);
+            bool success = true;
+#ifdef LOGGER_USE_ZLIB
+            if (m_mode == compression::gzip) {
+
+                const int zlib_flush = (flush == flush_mode::finish) ? Z_FINISH : (flush == flush_mode::sync) ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+                m_zlib_stream.next_in = reinterpret_cast<Bytef*>(pbase());
+                m_zlib_stream.avail_in = static_cast<uInt>(input_size);
+                int result = Z_OK;
+                do {
+                    m_zlib_stream.next_out = reinterpret_cast<Bytef*>(m_output.data());
+                    m_zlib_stream.avail_out = static_cast<uInt>(m_output.size());
+                    result = deflate(&m_zlib_stream, zlib_flush);
+                    if (result == Z_STREAM_ERROR) {
+                        success = false;
+                        break;
+                    }
+                    success &= write_output(m_output.size() - m_zlib_stream.avail_out);
+                } while (m_zlib_stream.avail_out == 0 || (zlib_flush == Z_FINISH && result != Z_STREAM_END));
+            }
 #endif
-#ifdef TIME_COUT_PERFORMANCE
-        std::cout << std::left << std::setw(40) << "[LOGGER] Cout performance:" << " counter [" << std::setw(8) << cout_counter << "] average time[" << cumulative_cout_duration / cout_counter << " micro-s]" << std::endl;
+#ifdef LOGGER_USE_ZSTD
+            if (m_mode == compression::zstd) {
+
+                const ZSTD_EndDirective directive = (flush == flush_mode::finish) ? ZSTD_e_end : (flush == flush_mode::sync) ? ZSTD_e_flush : ZSTD_e_continue;
+                ZSTD_inBuffer input = { pbase(), input_size, 0 };
+                size_t remaining = 0;
+                do {
+                    ZSTD_outBuffer output = { m_output.data(), m_output.size(), 0 };
+                    remaining = ZSTD_compressStream2(m_zstd_context, &output, &input, directive);
+                    if (ZSTD_isError(remaining)) {
+                        success = false;
+                        break;
+                    }
+                    success &= write_output(output.pos);
+                } while ((directive == ZSTD_e_continue) ? input.pos < input.size : remaining != 0);
+            }
 #endif
-#ifdef TIME_QUEUE_ADDING_PERFORMANCE
-        std::cout << std::left << std::setw(40) << "[LOGGER] Queue performance:" << " counter [" << std::setw(8) << queue_adding_counter << "] average time[" << cumulative_queue_adding_duration / queue_adding_counter << " micro-s]" << std::endl;
+            loc_stopwatch.stop();
+
+            input_bytes += input_size;
+            compress_counter++;
+            cumulative_compress_duration += m_compress_duration;
+            if (input_size > 0)
+                unflushed = true;
+            setp(m_input.data(), m_input.data() + m_input.size());
+            return success;
+        }
+
+        bool write_output(const size_t size) {
+
+            output_bytes += size;
+            return size == 0 || m_target->sputn(m_output.data(), static_cast<std::streamsize>(size)) == static_cast<std::streamsize>(size);
+        }
+
+        void release() {
+
+#ifdef LOGGER_USE_ZLIB
+            if (m_open && m_mode == compression::gzip)
+                deflateEnd(&m_zlib_stream);
 #endif
-#ifdef TIME_WRITING_TO_FILE_PERFORMANCE
-        std::cout << std::left << std::setw(40) << "[LOGGER] writing to file performance:" << " counter [" << std::setw(8) << writing_to_file_counter << "] average time[" << cumulative_writing_to_file_duration / writing_to_file_counter << " micro-s]" << std::endl;
+#ifdef LOGGER_USE_ZSTD
+            if (m_zstd_context != nullptr) {
+                ZSTD_freeCCtx(m_zstd_context);
+                m_zstd_context = nullptr;
+            }
 #endif
+            m_open = false;
+            setp(nullptr, nullptr);
+        }
 
-#ifdef TIME_MAIN_THREAD_PERFORMANCE
-        std::cout << std::left << std::setw(40) << "[LOGGER] main-thread logger performance:" << " counter [" << std::setw(8) << main_thread_counter << "] average time[" << cumulative_main_thread_duration / main_thread_counter << " micro-s]" << std::endl;
+        compression                                             m_mode = compression::none;
+        int                                                     m_level = 0;
+        bool                                                    m_open = false;
+        std::streambuf*                                         m_target = nullptr;
+        std::vector<char>                                       m_input{};
+        std::vector<char>                                       m_output{};
+        f32                                                     m_compress_duration = 0;
+#ifdef LOGGER_USE_ZLIB
+        z_stream                                                m_zlib_stream{};
+#endif
+#ifdef LOGGER_USE_ZSTD
+        ZSTD_CCtx*                                              m_zstd_context = nullptr;
 #endif
+    };
 
-        is_init = false;
-    }
+    // Stream buffer of [main_file] for init_options::shared_file, the file is opened with O_APPEND and written with write().
+    // The worker marks the end of every record, a write() only contains whole records and is at most [m_write_limit] bytes
+    // (a single larger record is written alone), so processes appending to the same file never tear each others lines
+    class append_streambuf : public std::streambuf {
+    public:
 
-    // ====================================================================================================================================
-    // settings
-    // ====================================================================================================================================
+        ~append_streambuf() { close_file(); }
 
-    void set_format(const std::string& new_format) {        // needed to insert this into the queue to preserve the order
+        bool open(const std::filesystem::path& path, const bool append, const u32 write_limit) {
 
-        if (!is_init) {
-        
-    		std::cerr << "Tryed to set logger format bevor logger was initalized" << std::endl;
-            return;
+            close_file();
+#ifdef __unix__
+            m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | ((append) ? 0 : O_TRUNC), 0644);
+#else
+            (void)path;
+            (void)append;
+#endif
+            m_write_limit = std::max<size_t>(write_limit, 1);
+            m_buffer.clear();
+            m_record_ends.clear();
+            return m_fd >= 0;
         }
 
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        log_queue.emplace(severity::Trace, "", LOGGER_UPDATE_FORMAT, 0, static_cast<std::thread::id>(0), std::move(new_format));
-        cv.notify_all();
-    }
-
-    void use_previous_format() {
-        
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        log_queue.emplace(severity::Trace, "", LOGGER_REVERSE_FORMAT, 0, static_cast<std::thread::id>(0), "");
-        cv.notify_all();
-    }
+        void close_file() {
 
-    const std::string get_format() { return format_current; }
+            if (m_fd < 0)
+                return;
 
-    void register_label_for_thread(const std::string& thread_lable, std::thread::id thread_id) {
+            sync();
+#ifdef __unix__
+            ::close(m_fd);
+#endif
+            m_fd = -1;
+        }
 
-        std::lock_guard<std::mutex> lock(general_mutex);
+        // everything bevor this point is a complete record
+        void end_record() {
 
-        if (thread_lable_map.find(thread_id) != thread_lable_map.end())
-            main_file << "[LOGGER] Thread with ID: [" << thread_id << "] already has lable [" << thread_lable_map[thread_id] << "] registered. Overriding with the lable: [" << thread_lable << "]\n";
-        else
-            main_file << "[LOGGER] Registering Thread-ID: [" << thread_id << "] with the lable: [" << thread_lable << "]\n";
+            m_record_ends.push_back(m_buffer.size());
+            if (m_buffer.size() >= m_write_limit)
+                write_records();
+        }
 
-        thread_lable_map[thread_id] = thread_lable;
-    }
+        bool is_open() const                                    { return m_fd >= 0; }
 
-    void unregister_label_for_thread(std::thread::id thread_id) {
+    protected:
 
-        if (thread_lable_map.find(thread_id) == thread_lable_map.end()) {
+        std::streamsize xsputn(const char* data, const std::streamsize size) override {
 
-            std::lock_guard<std::mutex> lock(general_mutex);
-            main_file << "[LOGGER] Tried to unregister lable for Thread-ID: [" << thread_id << "]. IGNORED\n";
-            return;
+            m_buffer.append(data, static_cast<size_t>(size));
+            return size;
         }
 
-        std::lock_guard<std::mutex> lock(general_mutex);
-        main_file << "[LOGGER] Unregistering Thread-ID: [" << thread_id << "] with the lable: [" << thread_lable_map[thread_id] << "]\n";
+        int_type overflow(int_type c) override {
 
-        thread_lable_map.erase(thread_id);
-    }
+            if (!traits_type::eq_int_type(c, traits_type::eof()))
+                m_buffer.push_back(traits_type::to_char_type(c));
+            return traits_type::not_eof(c);
+        }
 
-    // ====================================================================================================================================
-    // log message handeling
-    // ====================================================================================================================================
+        // all writers hold [general_mutex] and write whole lines, so the buffer only contains complete records here
+        int sync() override {
 
-    void process_update_in_msg_format(const message_format msg_format) {
+            m_record_ends.push_back(m_buffer.size());
+            return write_records() ? 0 : -1;
+        }
 
-        std::lock_guard<std::mutex> lock(general_mutex);
-        format_prev = format_current;
-        format_current = msg_format.message;
-        main_file << "[LOGGER] Changing log-format. From [" << format_prev << "] to [" << format_current << "]\n";
-    }
+    private:
 
-    void process_reverse_in_msg_format() {
+        // write all complete records, as many as fit into [m_write_limit] per write()
+        bool write_records() {
 
-        std::lock_guard<std::mutex> lock(general_mutex);
-        const std::string buffer = format_current;
-        format_current = format_prev;
-        format_prev = buffer;
-        main_file << "[LOGGER] Changing to previous log-format. From [" << format_prev << "] to [" << format_current << "]\n";
-    }
+            bool success = true;
+            size_t begin = 0;
+            for (size_t x = 0; x < m_record_ends.size(); ) {
 
-    void process_queue() {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        while (!stop) {
-            // Wait until there is a message in the queue or stop is signaled
-            cv.wait(lock, [] { return !log_queue.empty() || stop; });
-    
-            // Process all messages in the queue
-            while (!log_queue.empty()) {
-                // Get message from queue
-                message_format message = std::move(log_queue.front());
-                log_queue.pop();
-                lock.unlock(); // Unlock while processing the message
-    
-                if (strcmp(message.function_name, LOGGER_UPDATE_FORMAT) == 0)
-                    process_update_in_msg_format(std::move(message));
-                else if (strcmp(message.function_name, LOGGER_REVERSE_FORMAT) == 0)
-                    process_reverse_in_msg_format();
-                else
-                    process_log_message(std::move(message));
-    
-                lock.lock(); // Re-lock for the next iteration
+                size_t end = m_record_ends[x++];
+                while (x < m_record_ends.size() && m_record_ends[x] - begin <= m_write_limit)
+                    end = m_record_ends[x++];
+
+                if (end > begin)
+                    success &= write_all(m_buffer.data() + begin, end - begin);
+                begin = end;
             }
+
+            m_buffer.erase(0, begin);
+            m_record_ends.clear();
+            return success;
         }
-    }
 
-    void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const std::string& message) {
+        bool write_all(const char* data, size_t size) {
 
+#ifdef __unix__
+            while (size > 0) {
 
-        if (message.empty())
-            return;                      // dont log empty lines
+                const ssize_t written = ::write(m_fd, data, size);
+                if (written < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+#else
+            (void)data;
+            (void)size;
+            return false;
+#endif
+        }
 
-        
-        if (!is_init) {
+        int                                                     m_fd = -1;
+        size_t                                                  m_write_limit = 4096;
+        std::string                                             m_buffer{};
+        std::vector<size_t>                                     m_record_ends{};                        // offsets in [m_buffer] where a record ends
+    };
 
-    		std::cerr << "Tryed to log message bevor logger was initalized. SOURCE: file_name[" << file_name << "] function_name[" << function_name << "] line[" << line << "] thread_id[" << thread_id << "]  MESSAGE: [" << message << "] " << std::endl;
-            return;
+    // Stream buffer of [main_file] when the sidecar index is enabled, forwards everything to the file and counts the bytes.
+    // The index needs the offset of every message, tellp() on the file itself would flush its buffer & call lseek() every time
+    class counting_streambuf : public std::streambuf {
+    public:
+
+        void open(std::streambuf* target, const u64 position) {
+
+            m_target = target;
+            m_position = position;
         }
 
-        START_QUEUE_ADDING_TIMER
-        {
-            std::lock_guard<std::mutex> lock(queue_mutex);
-            log_queue.emplace(msg_sev, file_name, function_name, line, thread_id, std::move(message));
+        u64 position() const                                    { return m_position; }
+
+    protected:
+
+        std::streamsize xsputn(const char* data, const std::streamsize size) override {
+
+            const std::streamsize written = m_target->sputn(data, size);
+            m_position += static_cast<u64>(std::max<std::streamsize>(written, 0));
+            return written;
         }
-        cv.notify_all();
-        END_QUEUE_ADDING_TIMER
-    }
 
-    void process_log_message(const message_format&& message) {
+        int_type overflow(int_type c) override {
 
-        START_FORMATTING_TIMER
+            if (traits_type::eq_int_type(c, traits_type::eof()))
+                return traits_type::not_eof(c);
 
-        // Create Buffer vars
-        std::ostringstream Format_Filled;
-        Format_Filled.flush();
-        char Format_Command;
+            if (traits_type::eq_int_type(m_target->sputc(traits_type::to_char_type(c)), traits_type::eof()))
+                return traits_type::eof();
+            m_position++;
+            return c;
+        }
 
-        util::system_time loc_system_time = util::get_system_time();
+        int sync() override                                     { return m_target->pubsync(); }
 
-        // Loop over Format string and build Final Message
-        int FormatLen = static_cast<int>(format_current.length());
-        for (int x = 0; x < FormatLen; x++) {
+        // only tellp() is supported
+        pos_type seekoff(const off_type offset, const std::ios_base::seekdir direction, const std::ios_base::openmode) override {
 
-            if (format_current[x] == '$' && x + 1 < FormatLen) {
+            return (offset == 0 && direction == std::ios_base::cur) ? pos_type(static_cast<off_type>(m_position)) : pos_type(off_type(-1));
+        }
 
-                Format_Command = format_current[x + 1];
-                switch (Format_Command) {
+    private:
 
-                // ------------------------------------  Basic Info  -------------------------------------------------------------------------------
-                case 'B':   Format_Filled << console_color_table[(u8)message.msg_sev]; break;                                                                                               // Color Start
-                case 'E':   Format_Filled << console_reset; break;                                                                                                                          // Color End
-                case 'C':   Format_Filled << message.message; break;                                                                                                                        // input text (message)
-                case 'L':   Format_Filled << severity_names[(u8)message.msg_sev]; break;                                                                                                    // Log Level
-                case 'X':   if (message.msg_sev == severity::Info || message.msg_sev == severity::Warn) { Format_Filled << " "; } break;                                                    // Alignment
-                case 'Z':   Format_Filled << "\n"; break;                                                                                                                                   // Alignment
+        std::streambuf*                                         m_target = nullptr;
+        u64                                                     m_position = 0;
+    };
 
-                // ------------------------------------  Source  -------------------------------------------------------------------------------
-                case 'Q':   if (thread_lable_map.find(message.thread_id) != thread_lable_map.end()) {Format_Filled << thread_lable_map[message.thread_id]; } 
-                                                                                                    else { Format_Filled << message.thread_id; } break;                                     // Thread id or asosiated lable
-                case 'F':   Format_Filled << message.function_name; break;                                                                                                                  // Function Name
-                case 'P':   Format_Filled << SHORTEN_FUNC_NAME(message.function_name); break;                                                                                               // Function Name
-                case 'A':   Format_Filled << message.file_name; break;                                                                                                                      // File Name
-                case 'I':   Format_Filled << get_filename(message.file_name); break;                                                                                                        // Only File Name
-                case 'G':   Format_Filled << message.line; break;                                                                                                                           // Line
+    // Per call site counters (init_options::profile_call_sites). Sites are keyed by the __FILE__ pointer & line of the LOG() macro.
+    // Every formatting thread keeps its own lookup table, [m_mutex] is only taken the first time a thread sees a call site
+    class call_site_profiler {
+    public:
+
+        struct counters {
+            const char*                                         file_name;
+            const char*                                         function_name;
+            int                                                 line;
+            std::atomic<u64>                                    messages = 0;
+            std::atomic<u64>                                    bytes = 0;
+            std::atomic<u64>                                    formatting_ns = 0;
+        };
+
+        // forget all call sites, only called while no thread is formatting (init)
+        void reset() {
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_index.clear();
+            m_sites.clear();
+            m_generation = next_generation++;
+        }
 
-                // ------------------------------------  Time  -------------------------------------------------------------------------------
-                case 'T':   Format_Filled << SETW(2) << (u16)loc_system_time.hour << ":" << SETW(2) << (u16)loc_system_time.minute << ":" << SETW(2) << (u16)loc_system_time.secund; break; // Clock hh:mm:ss
-                case 'H':   Format_Filled << SETW(2) << (u16)loc_system_time.hour; break;                                                                                                   // Clock secunde
-                case 'M':   Format_Filled << SETW(2) << (u16)loc_system_time.minute; break;                                                                                                 // Clock minute
-                case 'S':   Format_Filled << SETW(2) << (u16)loc_system_time.secund; break;                                                                                                 // Clock second
-                case 'J':   Format_Filled << SETW(3) << (u16)loc_system_time.millisecends; break;                                                                                           // Clock millisec.
+        // can be called from any thread
+        void record(const message_format& message, const size_t bytes, const u64 formatting_ns) {
 
-                // ------------------------------------  Date  -------------------------------------------------------------------------------
-                case 'N':   Format_Filled << SETW(4) << (u16)loc_system_time.year << "/" << SETW(2) << (u16)loc_system_time.month << "/" << SETW(2) << (u16)loc_system_time.day; break;     // Data yyyy/mm/dd
-                case 'Y':   Format_Filled << SETW(4) << (u16)loc_system_time.year; break;                                                                                                   // Year
-                case 'O':   Format_Filled << SETW(2) << (u16)loc_system_time.month; break;                                                                                                  // Month
-                case 'D':   Format_Filled << SETW(2) << (u16)loc_system_time.day; break;                                                                                                    // Day
+            struct local_table {
+                u32                                             generation = 0;
+                std::unordered_map<site_key, counters*, site_key_hash> sites{};
+            };
+            static thread_local std::unordered_map<const call_site_profiler*, local_table> local_tables{};
 
-                // ------------------------------------  Default  -------------------------------------------------------------------------------
-                default: break;
-                }
+            local_table& table = local_tables[this];
+            if (table.generation != m_generation) {
 
-                x++;
+                table.sites.clear();
+                table.generation = m_generation;
             }
 
-            else
-                Format_Filled << format_current[x];
+            const site_key key{ message.file_name, message.line };
+            auto site = table.sites.find(key);
+            if (site == table.sites.end())
+                site = table.sites.emplace(key, register_site(message)).first;
+
+            site->second->messages.fetch_add(1, std::memory_order_relaxed);
+            site->second->bytes.fetch_add(bytes, std::memory_order_relaxed);
+            site->second->formatting_ns.fetch_add(formatting_ns, std::memory_order_relaxed);
         }
 
-        END_FORMATTING_TIMER
+        // @param max_count 0 => all call sites
+        std::vector<call_site_stats> collect(const u32 max_count) {
 
-        {
-#ifdef TIME_WRITING_TO_FILE_PERFORMANCE            
-            START_TIMER(writing_to_file)
-#endif
-            std::lock_guard<std::mutex> file_lock(general_mutex);
-            main_file << Format_Filled.str();
+            std::vector<call_site_stats> result;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                result.reserve(m_sites.size());
+                for (const counters& site : m_sites) {
 
-#ifdef TIME_WRITING_TO_FILE_PERFORMANCE
-            END_TIMER(writing_to_file)
+                    const u64 messages = site.messages.load(std::memory_order_relaxed);
+                    const f32 average_formatting_time = (messages > 0) ? site.formatting_ns.load(std::memory_order_relaxed) / 1000.f / messages : 0;
+                    result.push_back({ site.file_name, site.function_name, site.line, messages, site.bytes.load(std::memory_order_relaxed), average_formatting_time });
+                }
+            }
+
+            std::sort(result.begin(), result.end(), [](const call_site_stats& a, const call_site_stats& b) { return a.bytes > b.bytes; });
+            if (max_count > 0 && result.size() > max_count)
+                result.resize(max_count);
+            return result;
+        }
+
+        std::mutex& mutex()                                     { return m_mutex; }
+
+    private:
+
+        struct site_key {
+            const char*                                         file_name;
+            int                                                 line;
+            bool operator==(const site_key& other) const        { return file_name == other.file_name && line == other.line; }
+        };
+        struct site_key_hash {
+            size_t operator()(const site_key& key) const        { return std::hash<const void*>{}(key.file_name) ^ (static_cast<size_t>(key.line) * 0x9E3779B97F4A7C15ull); }
+        };
+
+        counters* register_site(const message_format& message) {
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const site_key key{ message.file_name, message.line };
+            auto site = m_index.find(key);
+            if (site != m_index.end())
+                return site->second;                                // already registered by another thread
+
+            counters& new_site = m_sites.emplace_back();
+            new_site.file_name = message.file_name;
+            new_site.function_name = message.function_name;
+            new_site.line = message.line;
+            m_index.emplace(key, &new_site);
+            return &new_site;
+        }
+
+        inline static std::atomic<u32>                          next_generation = 1;
+
+        std::mutex                                              m_mutex{};
+        std::deque<counters>                                    m_sites{};                              // deque => stable addresses for the thread tables
+        std::unordered_map<site_key, counters*, site_key_hash>  m_index{};
+        std::atomic<u32>                                        m_generation = 0;
+    };
+
+    // FIFO of log messages that keeps its storage, once it reached the peak size of the queue enqueuing never allocates
+    // (std::queue on a std::deque allocates a new block every few messages). The capacity is always a power of two
+    class message_queue {
+    public:
+
+        bool empty() const                                      { return m_count == 0; }
+        size_t size() const                                     { return m_count; }
+        message_format& front()                                 { return m_slots[m_head]; }
+
+        void push(message_format&& message) {
+
+            if (m_count == m_slots.size())
+                grow();
+            m_slots[(m_head + m_count) & (m_slots.size() - 1)] = std::move(message);
+            m_count++;
+        }
+
+        // the slot keeps whatever is left in front(), move the message out bevor
+        void pop() {
+
+            m_head = (m_head + 1) & (m_slots.size() - 1);
+            m_count--;
+        }
+
+        void clear() {
+
+            m_slots.clear();
+            m_head = 0;
+            m_count = 0;
+        }
+
+    private:
+
+        void grow() {
+
+            std::vector<message_format> slots(std::max<size_t>(m_slots.size() * 2, 256));
+            for (size_t x = 0; x < m_count; x++)
+                slots[x] = std::move(m_slots[(m_head + x) & (m_slots.size() - 1)]);
+            m_slots = std::move(slots);
+            m_head = 0;
+        }
+
+        std::vector<message_format>                             m_slots{};
+        size_t                                                  m_head = 0;
+        size_t                                                  m_count = 0;
+    };
+
+    // The queues of the priority lanes (init_options::priority_lanes), lane 0 is drained first. Without lanes everything goes into lane 0
+    class log_lanes {
+    public:
+
+        static constexpr size_t                                 count = 3;
+
+        // @return 0 = Error/Fatal, 1 = Info/Warn, 2 = Trace/Debug
+        static size_t lane_of(const severity msg_sev)           { return (msg_sev >= severity::Error) ? 0 : (msg_sev >= severity::Info) ? 1 : 2; }
+
+        bool empty() const                                      { return m_size == 0; }
+        size_t size() const                                     { return m_size; }
+
+        void push(message_format&& message, const size_t lane) {
+
+            m_lanes[lane].push(std::move(message));
+            m_size++;
+        }
+
+        // @return the lane with the highest priority whose next message has a sequence number below [limit], nullptr if there is none
+        message_queue* next(const u64 limit) {
+
+            for (message_queue& lane : m_lanes)
+                if (!lane.empty() && lane.front().sequence < limit)
+                    return &lane;
+            return nullptr;
+        }
+
+        // @param lane Returned by next()
+        message_format take(message_queue& lane) {
+
+            message_format message = std::move(lane.front());
+            lane.pop();
+            m_size--;
+            return message;
+        }
+
+        void clear() {
+
+            for (message_queue& lane : m_lanes)
+                lane.clear();
+            m_size = 0;
+        }
+
+    private:
+
+        message_queue                                           m_lanes[count]{};
+        size_t                                                  m_size = 0;
+    };
+
+    // Console output of an instance (log_to_console). Formatted messages are only appended to [m_pending], the console thread writes
+    // them with few large write() calls. A slow terminal or pipe never stalls the worker: once [max_pending] bytes are waiting, messages
+    // are dropped until the console caught up and summarized by one line. Color codes ($B/$E) are removed if stdout is not a terminal
+    class console_writer {
+    public:
+
+        static constexpr size_t                                 max_pending = 1024 * 1024;
+        static constexpr size_t                                 wake_threshold = 64 * 1024;         // append() wakes the console thread itself above this
+
+        console_writer()
+            : m_strip_colors(!stdout_is_terminal()) {}
+
+        ~console_writer()                                       { stop(); }
+
+        u64 dropped_messages() const                            { return m_dropped.load(std::memory_order_relaxed); }
+
+        // the console thread is only woken by wake() or once [wake_threshold] bytes are pending, so a batch is written at once
+        // @param message_count Number of messages in [text], only used to count dropped messages
+        void append(const std::string_view text, const u64 message_count = 1) {
+
+            bool wake = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_dropped_unreported > 0 || (!m_pending.empty() && m_pending.size() + text.size() > max_pending)) {
+
+                    m_dropped_unreported += message_count;
+                    m_dropped.fetch_add(message_count, std::memory_order_relaxed);
+                    return;
+                }
+
+                add(m_pending, text);
+                if (!m_thread)
+                    m_thread = std::make_unique<std::thread>(&console_writer::run, this);
+                wake = m_waiting && m_pending.size() >= wake_threshold;
+            }
+            if (wake)
+                m_cv->notify_one();
+        }
+
+        // start writing everything pending, called at the end of a batch
+        void wake() {
+
+            bool wake = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                wake = m_waiting && (!m_pending.empty() || m_dropped_unreported > 0);
+            }
+            if (wake)
+                m_cv->notify_one();
+        }
+
+        // write everything pending and [text] on the calling thread (init_options::synchronous_errors)
+        void write_now(const std::string_view text) {
+
+            std::lock_guard<std::mutex> write_lock(m_write_mutex);
+            std::string output;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                take_pending(output);
+                add(output, text);
+            }
+            write_all(output);
+        }
+
+        // write everything pending and end the console thread, append() starts a new one
+        void stop() {
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_thread)
+                    return;
+                m_stop = true;
+            }
+            m_cv->notify_one();
+            m_thread->join();
+            m_thread.reset();
+            m_stop = false;
+        }
+
+        void prepare_fork() {
+
+            m_write_mutex.lock();
+            m_mutex.lock();
+        }
+
+        // the parent writes everything pending, the child starts without a console thread
+        void after_fork(const bool in_child) {
+
+            if (in_child) {
+
+                // the console thread doesn't exist in the child, its objects are leaked (destroying them would terminate or block)
+                (void)m_thread.release();
+                (void)m_cv.release();
+                m_cv = std::make_unique<std::condition_variable>();
+                m_pending.clear();
+                m_dropped_unreported = 0;
+                m_waiting = false;
+            }
+
+            m_mutex.unlock();
+            m_write_mutex.unlock();
+        }
+
+    private:
+
+        static bool stdout_is_terminal() {
+
+#ifdef __unix__
+            return isatty(STDOUT_FILENO) == 1;
+#else
+            return true;
+#endif
+        }
+
+        // the text is written directly to the file descriptor, std::cout is bypassed
+        static void write_all(std::string_view data) {
+
+#ifdef __unix__
+            while (!data.empty()) {
+
+                const ssize_t written = write(STDOUT_FILENO, data.data(), data.size());
+                if (written < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    return;                                         // stdout is closed, the output is lost
+                }
+                data.remove_prefix(static_cast<size_t>(written));
+            }
+#else
+            std::fwrite(data.data(), 1, data.size(), stdout);
+            std::fflush(stdout);
+#endif
+        }
+
+        // removes SGR sequences ("\x1b[...m") while copying, the text is only scanned for ESC if stdout is not a terminal
+        void add(std::string& output, std::string_view text) const {
+
+            if (!m_strip_colors) {
+                output.append(text);
+                return;
+            }
+
+            for (size_t escape = text.find('\x1b'); escape != std::string_view::npos; escape = text.find('\x1b')) {
+
+                output.append(text.substr(0, escape));
+                size_t end = escape + 1;
+                if (end < text.size() && text[end] == '[') {
+
+                    end++;
+                    while (end < text.size() && (std::isdigit(static_cast<unsigned char>(text[end])) || text[end] == ';'))
+                        end++;
+                    if (end < text.size() && text[end] == 'm')
+                        end++;
+                }
+                text.remove_prefix(end);
+            }
+            output.append(text);
+        }
+
+        // called while holding [m_mutex]
+        void take_pending(std::string& output) {
+
+            output.swap(m_pending);
+            m_pending.clear();
+            if (m_dropped_unreported > 0) {
+
+                output += "[LOGGER] console output can't keep up, dropped [" + std::to_string(m_dropped_unreported) + "] messages\n";
+                m_dropped_unreported = 0;
+            }
+        }
+
+        void run() {
+
+            std::string output;
+            while (true) {
+
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_waiting = true;
+                    m_cv->wait(lock, [this] { return !m_pending.empty() || m_dropped_unreported > 0 || m_stop; });
+                    m_waiting = false;
+                    if (m_pending.empty() && m_dropped_unreported == 0)
+                        return;                                             // [m_stop] and everything is written
+                }
+
+                std::lock_guard<std::mutex> write_lock(m_write_mutex);      // keeps the order with write_now()
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    take_pending(output);
+                }
+                write_all(output);
+                output.clear();
+            }
+        }
+
+        const bool                                              m_strip_colors;
+        std::mutex                                              m_write_mutex{};                    // held while writing to stdout
+        std::mutex                                              m_mutex{};                          // guards everything below
+        std::unique_ptr<std::condition_variable>                m_cv = std::make_unique<std::condition_variable>();
+        std::string                                             m_pending = "";
+        u64                                                     m_dropped_unreported = 0;
+        std::atomic<u64>                                        m_dropped = 0;
+        bool                                                    m_waiting = false;
+        bool                                                    m_stop = false;
+        std::unique_ptr<std::thread>                            m_thread{};
+    };
+
+    // Messages that are formatted together by one formatter thread (init_options::formatter_threads)
+    // Everything the formatter needs is copied when the worker cuts the chunk, so commands bevor it are already applied
+    struct format_chunk {
+        std::vector<message_format>                             messages{};
+        std::string                                             format = "";                        // copy of [format_current]
+        std::shared_ptr<const level_rules>                      levels{};
+        std::shared_ptr<const lable_map>                        thread_lables{};
+        std::string                                             output = "";                        // all formatted messages back to back
+        std::vector<u32>                                        message_sizes{};                    // size of every message in [output], 0 => disabled by [levels]
+        f32                                                     formatting_duration = 0;
+        call_site_profiler*                                     profiler = nullptr;                 // nullptr => call sites are not profiled
+        u32                                                     stack_trace_depth = 0;              // copy of [stack_trace_depth]
+        bool                                                    ready = false;                      // guarded by [formatter_mutex]
+    };
+
+    // Everything one logger instance owns (queue, worker, files, format). Nothing in here is shared between instances
+    struct instance::impl {
+
+        bool init(const std::string& format, const bool log_to_console, const std::filesystem::path log_dir, const std::string& main_log_file_name, const bool use_append_mode, const init_options& options);
+        void shutdown();
+        void set_format(const std::string& new_format);
+        void use_previous_format();
+        void register_label_for_thread(const std::string& thread_lable, std::thread::id thread_id);
+        void unregister_label_for_thread(std::thread::id thread_id);
+        void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, std::string&& message);
+        void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const static_text message);
+        bool accept_message(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const std::string_view message);
+        void submit_message(message_format&& message);
+        void enqueue_message(message_format&& message);
+        void write_message_now(message_format&& message, std::deque<message_format>* backtrace);
+
+        std::future<void> flush_async();
+        void dump_backtrace();
+
+        void record_backtrace(message_format&& message);
+        std::deque<message_format> take_backtrace();
+        void push_backtrace(std::deque<message_format>&& backtrace);
+        void process_update_in_msg_format(const std::string& new_format);
+        void process_reverse_in_msg_format();
+        void process_control_message(control_message&& control);
+        void process_batch_end();
+        int open_sync_descriptor();
+        void sync_main_file(const bool data_only);
+        void wait_for_work(std::unique_lock<std::mutex>& lock);
+        void setup_worker_thread(const init_options& options);
+        void process_queue();
+        void process_log_message(const message_format&& message);
+        void run_formatter();
+        void dispatch_format_chunk(std::unique_ptr<format_chunk>&& chunk);
+        void write_format_chunks(const size_t max_in_flight);
+        void write_format_chunk(format_chunk& chunk);
+        void write_call_site_report();
+        void socket_add_record(const message_format& message, const std::string_view formatted_message);
+        void socket_end_batch();
+        void socket_send_pending();
+        bool socket_connect();
+        void socket_disconnect(const char* reason);
+        void socket_shutdown();
+        void prepare_fork();
+        void pause_for_fork(std::unique_lock<std::mutex>& lock);
+        void after_fork(const bool in_child);
+        void open_process_main_file();
+        static void fork_prepare();
+        static void fork_parent();
+        static void fork_child();
+
+        // instances with a running worker, locked by the fork handlers from prepare until parent/child
+        inline static std::mutex                                live_instances_mutex{};
+        inline static std::vector<impl*>                        live_instances{};
+        bool open_index_file(const bool append);
+        void index_add_message(const message_format& message, const size_t message_size);
+        void index_close_block(const u64 end_offset);
+        void index_write_pending();
+        void open_thread_file(const std::string& thread_lable, std::thread::id thread_id);
+        bool load_config_file(runtime_config& config);
+        void watch_config_file();
+        void apply_config(runtime_config&& config);
+        std::shared_ptr<thread_file> get_thread_file();
+        void write_thread_file(thread_file& file, const message_format& message);
+
+        // const after init() and bevor shutdown()
+        const u64                                               instance_id = next_instance_id++;
+        std::atomic<bool>                                       is_init = false;
+        std::atomic<bool>                                       write_logs_to_console = false;
+        console_writer                                          console{};                          // used by every thread that writes messages
+        std::filesystem::path                                   main_log_dir = "";
+        std::filesystem::path                                   main_log_file_path = "";
+        std::unique_ptr<std::thread>                            worker_thread{};
+
+        // thread savety related
+        std::unique_ptr<std::condition_variable>                cv = std::make_unique<std::condition_variable>();
+        std::mutex                                              queue_mutex{};                      // only queue related
+        std::mutex                                              general_mutex{};                    // for everything else
+        std::atomic<bool>                                       stop = false;
+        std::atomic<u64>                                        work_counter = 0;                   // incremented for every message, command or config, polled by the worker
+        bool                                                    worker_parked = false;              // guarded by [queue_mutex], producers only notify if set
+        bool                                                    worker_running = false;             // guarded by [queue_mutex], set by the worker itself
+        bool                                                    fork_pending = false;               // guarded by [queue_mutex], prepare_fork() waits for the worker to pause
+        bool                                                    worker_paused = false;              // guarded by [queue_mutex], the worker waits in pause_for_fork()
+        std::unique_ptr<std::condition_variable>                fork_cv = std::make_unique<std::condition_variable>();
+        wait_strategy                                           worker_wait_strategy = wait_strategy::block;
+        u32                                                     spin_budget = 0;
+
+        std::string                                             format_current = "";
+        std::string                                             format_prev = "";
+        std::atomic<u32>                                        config_version = 0;                 // incremented on every format or level change
+        std::ofstream                                           main_file;
+        lable_map                                               thread_lable_map = {};
+        std::shared_ptr<const lable_map>                        thread_lable_snapshot = std::make_shared<const lable_map>();   // copy of [thread_lable_map] for the formatter threads, guarded by [general_mutex]
+        log_lanes                                               log_queue{};                        // guarded by [queue_mutex]
+        std::queue<control_message>                             control_queue{};                    // guarded by [queue_mutex]
+        u64                                                     next_sequence = 0;                  // guarded by [queue_mutex], message_format::sequence of the next message
+        bool                                                    priority_lanes = false;             // const after init()
+        bool                                                    synchronous_errors = false;         // const after init()
+
+        // durability (only touched by the worker after init())
+        durability                                              durability_mode = durability::none;
+        std::chrono::milliseconds                               fsync_interval{1000};
+        std::chrono::steady_clock::time_point                   next_sync{};
+        bool                                                    unsynced_data = false;              // something was written since the last sync
+        int                                                     main_file_sync_fd = -1;             // second descriptor of the main file, only used for fsync(). Opened on the first sync (guarded by [general_mutex])
+
+        // compression of the main file / shared file (stream buffers of [main_file], guarded by [general_mutex] like the file)
+        compressed_streambuf                                    compressor{};
+        append_streambuf                                        shared_buffer{};
+        std::chrono::milliseconds                               compression_flush_interval{1000};
+        std::chrono::steady_clock::time_point                   next_compression_flush{};
+
+        // runtime config (written by the worker between batches)
+        std::shared_ptr<const level_rules>                      levels = std::make_shared<const level_rules>();
+        std::atomic<u8>                                         lowest_level = 0;                   // copy of [levels->lowest] for the calling threads
+        bool                                                    flush_each_batch = false;
+        std::filesystem::path                                   config_file_path = "";
+        std::unique_ptr<std::thread>                            config_thread{};
+        int                                                     config_wakeup_fd = -1;              // eventfd to stop [config_thread]
+        std::unique_ptr<runtime_config>                         pending_config{};                   // guarded by [queue_mutex]
+        std::atomic<bool>                                       config_pending = false;
+
+        // formatter pool, chunks are cut, dispatched and written by the worker in enqueue order
+        std::vector<std::unique_ptr<std::thread>>               formatter_pool{};
+        u32                                                     formatter_chunk_size = 256;
+        size_t                                                  max_chunks_in_flight = 0;           // the worker waits for the oldest chunk above this
+        std::mutex                                              formatter_mutex{};
+        std::unique_ptr<std::condition_variable>                formatter_cv = std::make_unique<std::condition_variable>();          // new job or [formatter_stop]
+        std::unique_ptr<std::condition_variable>                formatter_done_cv = std::make_unique<std::condition_variable>();     // a chunk is ready
+        std::deque<format_chunk*>                               formatter_jobs{};                   // guarded by [formatter_mutex]
+        bool                                                    formatter_stop = false;             // guarded by [formatter_mutex]
+        std::deque<std::unique_ptr<format_chunk>>               chunks_in_flight{};                 // only touched by the worker, oldest first
+
+        // backtrace ring, const after init() except the rings themselfs
+        u32                                                     backtrace_size = 0;                 // 0 => disabled
+        severity                                                backtrace_level = severity::Info;
+        severity                                                backtrace_trigger = severity::Error;
+        bool                                                    backtrace_per_thread = false;
+        u32                                                     backtrace_generation = 0;           // incremented in init(), invalidates the per thread rings of the last session
+        std::mutex                                              backtrace_mutex{};
+        backtrace_ring                                          global_backtrace{};                 // guarded by [backtrace_mutex]
+
+        // call site profiler
+        bool                                                    profile_call_sites = false;         // const after init()
+        call_site_profiler                                      profiler{};
+        std::chrono::milliseconds                               call_site_report_interval{0};       // 0 => no report
+        u32                                                     call_site_report_count = 10;
+        std::chrono::steady_clock::time_point                   next_call_site_report{};            // only touched by the worker
+        u64                                                     call_site_report_bytes = 0;         // only touched by the worker, total bytes of the last report
+
+        // stack trace capture, const after init()
+        u32                                                     stack_trace_depth = 0;              // 0 => disabled
+        severity                                                stack_trace_level = severity::Fatal;
+
+        // socket sink (guarded by [socket_mutex] after init(), it's taken bevor [general_mutex]). Records are added by the worker and by synchronous_errors
+        std::mutex                                              socket_mutex{};
+        std::string                                             socket_path = "";                   // empty => disabled, const after init()
+        socket_record_type                                      socket_record = socket_record_type::formatted;
+        int                                                     socket_fd = -1;
+        std::string                                             socket_batch = "";                  // frame of the current batch, starts with space for the header
+        u32                                                     socket_batch_records = 0;
+        std::deque<std::string>                                 socket_pending{};                   // complete frames, oldest first
+        size_t                                                  socket_pending_bytes = 0;
+        size_t                                                  socket_sent_offset = 0;             // bytes of [socket_pending.front()] already sent
+        size_t                                                  socket_buffer_size = 0;
+        std::chrono::milliseconds                               socket_reconnect_interval{1000};
+        std::chrono::steady_clock::time_point                   next_socket_attempt{};
+        u64                                                     socket_sent_records = 0;
+        u64                                                     socket_dropped_records = 0;
+        u64                                                     socket_dropped_reported = 0;        // part of [socket_dropped_records] already noted in the main file
+
+        // sidecar index (only touched by worker_thread after init())
+        u32                                                     index_block_size = 0;               // in bytes, 0 => disabled
+        std::ofstream                                           index_file;
+        counting_streambuf                                      index_counter{};                    // rdbuf() of [main_file], knows the offset of every message
+        index_entry                                             index_block{};                      // currently open block
+        u64                                                     index_block_bytes = 0;              // bytes written into the open block
+        std::vector<index_record>                               index_block_records{};              // messages of the open block, [time_offset] is set when it's closed
+        std::vector<int64>                                      index_block_timestamps{};           // milliseconds since epoch, one per [index_block_records]
+        std::vector<index_entry>                                index_pending{};                    // closed blocks, written at the next batch boundary
+        std::vector<index_record>                               index_pending_records{};            // records of all [index_pending] blocks back to back
+        std::unordered_map<std::thread::id, u64>                index_thread_id_bits = {};          // cache for threads without a lable
+
+        // per thread files (guarded by [general_mutex], the files themselfs are only written by their thread)
+        bool                                                    per_thread_files = false;
+        bool                                                    use_append_mode = false;
+        std::unordered_set<std::string>                         thread_file_names = {};             // all thread files opened since init()
+        std::unordered_map<std::thread::id, std::shared_ptr<thread_file>> thread_files = {};
+        std::atomic<u32>                                        thread_files_generation = 0;        // incremented when [thread_files] changes
+
+#ifdef TIME_FORMATTER_PERFORMANCE
+        u32                                                     formatting_counter = 0;
+        f32                                                     cumulative_formatting_duration = 0;
+#endif
+#ifdef TIME_LOGGING_PERFORMANCE
+        u32                                                     logging_counter = 0;
+        f32                                                     cumulative_logging_duration = 0;
+#endif
+#ifdef TIME_COUT_PERFORMANCE
+        u32                                                     cout_counter = 0;
+        f32                                                     cumulative_cout_duration = 0;
+#endif
+#ifdef TIME_QUEUE_ADDING_PERFORMANCE
+        u32                                                     queue_adding_counter = 0;
+        f32                                                     cumulative_queue_adding_duration = 0;
+#endif
+#ifdef TIME_WRITING_TO_FILE_PERFORMANCE
+        u32                                                     writing_to_file_counter = 0;
+        f32                                                     cumulative_writing_to_file_duration = 0;
+#endif
+#ifdef TIME_END_TO_END_PERFORMANCE
+        u32                                                     end_to_end_counter = 0;
+        f32                                                     cumulative_end_to_end_duration = 0;
+        f32                                                     max_end_to_end_duration = 0;
+#endif
+    };
+
+    void detach_crash_handler();
+
+    void format_message(std::ostringstream& Format_Filled, const std::string& format, const message_format& message, const std::string* thread_lable, const u32 stack_trace_depth);
+
+
+#define OPEN_MAIN_FILE(append)              { if (!main_file.is_open()) {                                                                               \
+                                                main_file = std::ofstream(main_log_file_path, (append) ? std::ios::app : std::ios::out);                \
+                                                if (!main_file.is_open())                                                                               \
+                                                    DEBUG_BREAK("FAILED to open log main_file") } }
+
+#define CLOSE_MAIN_FILE()                   { static_cast<std::ostream&>(main_file).rdbuf(main_file.rdbuf());                                           \
+                                              main_file.close(); }
+
+
+
+    // ====================================================================================================================================
+    // init / shutdown
+    // ====================================================================================================================================
+
+    bool instance::impl::init(const std::string& format, const bool log_to_console, const std::filesystem::path log_dir, const std::string& main_log_file_name, const bool use_append_mode, const init_options& options) {
+
+        if (is_init)
+            DEBUG_BREAK("Tryed to init lgging system multiple times")
+
+        stop = false;
+        format_current = format;
+        format_prev = format;
+        write_logs_to_console = log_to_console;
+        per_thread_files = options.per_thread_files;
+        this->use_append_mode = use_append_mode;
+        thread_file_names.clear();
+
+        main_log_dir = log_dir;
+        main_log_file_path = log_dir / main_log_file_name;
+
+        const compression compression_mode = (options.shared_file) ? compression::none : compressed_streambuf::supported(options.main_file_compression);
+        if (compression_mode == compression::gzip)
+            main_log_file_path += ".gz";
+        else if (compression_mode == compression::zstd)
+            main_log_file_path += ".zst";
+
+        // opening the file is the only filesystem access of init(), the directory is only created if that fails
+        const auto open_main_file = [&]() -> bool {
+
+            if (options.shared_file)
+                return shared_buffer.open(main_log_file_path, use_append_mode, options.shared_write_limit);
+
+            main_file = std::ofstream(main_log_file_path, std::ios::binary | ((use_append_mode) ? std::ios::app : std::ios::out));
+            return main_file.is_open();
+        };
+
+        if (!open_main_file()) {
+
+            std::error_code error;
+            std::filesystem::create_directories(log_dir, error);
+            if (error)
+                DEBUG_BREAK("FAILED to create directory for log files [" << log_dir.string() << "]: " << error.message())
+            if (!open_main_file())
+                DEBUG_BREAK(((options.shared_file) ? "FAILED to open shared log main_file" : "FAILED to open log main_file"))
+        }
+
+        if (options.shared_file)
+            static_cast<std::ostream&>(main_file).rdbuf(&shared_buffer);
+
+        if (compression_mode != compression::none) {            // appended sessions become a new gzip member / zstd frame
+
+            if (!compressor.open(compression_mode, main_file.rdbuf(), options.compression_level))
+                DEBUG_BREAK("FAILED to initialize compression of log main_file")
+            static_cast<std::ostream&>(main_file).rdbuf(&compressor);
+            compression_flush_interval = std::chrono::milliseconds(options.compression_flush_interval_ms);
+            next_compression_flush = std::chrono::steady_clock::now() + compression_flush_interval;
+        }
+
+        if (use_append_mode)
+            main_file << "\n=============================================================================\n";
+
+        // add some general info to beginning of file
+        auto now = std::time(nullptr);
+        auto tm = *std::localtime(&now);
+        main_file << "Log initialized at [" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "]\n"
+            << "Inital Log Format: '" << format << "' \nEnabled Log Levels: ";
+
+        const char* log_sev_strings[] = { "Fatal", " + Error", " + Warn", " + Info", " + Debug", " + Trace"};
+        for (int x = 0; x < LOG_LEVEL_ENABLED +2; x++)
+            main_file << log_sev_strings[x];
+        main_file << "\n=============================================================================\n";
+
+        if (options.shared_file && options.main_file_compression != compression::none)
+            main_file << "[LOGGER] Compression is not supported for shared files. IGNORED\n";
+        else if (compression_mode != options.main_file_compression)
+            main_file << "[LOGGER] Requested compression is not available in this build, using [" << ((compression_mode == compression::gzip) ? "gzip" : "none") << "]\n";
+
+        if (options.index_block_size_kb > 0 && (compressor.is_open() || shared_buffer.is_open()))
+            main_file << "[LOGGER] The sidecar index is not supported for compressed or shared log files. IGNORED\n";
+
+        if (options.index_block_size_kb > 0 && !compressor.is_open() && !shared_buffer.is_open()) {
+
+            index_block_size = std::min<u32>(options.index_block_size_kb, 1024 * 1024) * 1024;     // offsets of index_record are 32-bit
+            if (!open_index_file(use_append_mode))
+                DEBUG_BREAK("FAILED to open log index_file")
+        }
+
+        levels = std::make_shared<const level_rules>();
+        lowest_level = static_cast<u8>(severity::Trace);
+        flush_each_batch = false;
+        durability_mode = options.durability_mode;
+        fsync_interval = std::chrono::milliseconds(options.fsync_interval_ms);
+        next_sync = std::chrono::steady_clock::now() + fsync_interval;
+        unsynced_data = false;
+        next_sequence = 0;
+        priority_lanes = options.priority_lanes;
+        synchronous_errors = options.synchronous_errors;
+        config_file_path = options.config_file;
+        if (!config_file_path.empty()) {
+
+            runtime_config config{};
+            if (load_config_file(config))
+                apply_config(std::move(config));
+
+#ifdef __linux__
+            config_wakeup_fd = eventfd(0, EFD_CLOEXEC);
+            config_thread = std::make_unique<std::thread>(&impl::watch_config_file, this);
+#endif
+        }
+
+        socket_path = options.socket_path.string();
+        socket_record = options.socket_record;
+        socket_buffer_size = static_cast<size_t>(options.socket_buffer_kb) * 1024;
+        socket_reconnect_interval = std::chrono::milliseconds(options.socket_reconnect_ms);
+        next_socket_attempt = {};
+        socket_sent_records = 0;
+        socket_dropped_records = 0;
+        socket_dropped_reported = 0;
+#ifndef __unix__
+        if (!socket_path.empty()) {
+            main_file << "[LOGGER] The socket sink is only supported on unix. IGNORED\n";
+            socket_path.clear();
+        }
+#endif
+
+        worker_wait_strategy = options.worker_wait_strategy;
+        spin_budget = options.spin_budget;
+        backtrace_size = options.backtrace_size;
+        backtrace_level = options.backtrace_level;
+        backtrace_trigger = options.backtrace_trigger;
+        backtrace_per_thread = options.backtrace_per_thread;
+        backtrace_generation++;
+        stack_trace_depth = options.stack_trace_depth;
+        stack_trace_level = options.stack_trace_level;
+#ifndef __linux__
+        if (stack_trace_depth > 0) {
+            main_file << "[LOGGER] Stack traces are only supported on linux. IGNORED\n";
+            stack_trace_depth = 0;
+        }
+#endif
+        {
+            std::lock_guard<std::mutex> lock(backtrace_mutex);
+            global_backtrace.messages.clear();
+        }
+
+        profile_call_sites = options.profile_call_sites;
+        call_site_report_interval = std::chrono::milliseconds((profile_call_sites) ? options.call_site_report_interval_ms : 0);
+        call_site_report_count = std::max<u32>(options.call_site_report_count, 1);
+        next_call_site_report = std::chrono::steady_clock::now() + call_site_report_interval;
+        call_site_report_bytes = 0;
+        profiler.reset();
+
+        if (per_thread_files) {                                     // lables registered bevor init() or kept over a shutdown() get their files now
+
+            std::lock_guard<std::mutex> lock(general_mutex);
+            for (const auto& [thread_id, thread_lable] : thread_lable_map)
+                open_thread_file(thread_lable, thread_id);
+        }
+
+        thread_lable_snapshot = std::make_shared<const lable_map>(thread_lable_map);
+        formatter_chunk_size = std::max<u32>(options.formatter_chunk_size, 1);
+        max_chunks_in_flight = 4 * static_cast<size_t>(options.formatter_threads);
+        formatter_stop = false;
+        for (u32 x = 0; x < options.formatter_threads; x++)
+            formatter_pool.push_back(std::make_unique<std::thread>(&impl::run_formatter, this));
+
+        worker_parked = false;
+        worker_thread = std::make_unique<std::thread>(&impl::process_queue, this);
+        setup_worker_thread(options);
+
+#ifdef __unix__
+        static std::once_flag fork_handlers_registered;
+        std::call_once(fork_handlers_registered, [] { pthread_atfork(&impl::fork_prepare, &impl::fork_parent, &impl::fork_child); });
+        {
+            std::lock_guard<std::mutex> lock(live_instances_mutex);
+            live_instances.push_back(this);
+        }
+#endif
+
+        is_init = true;
+        return true;
+    }
+
+    void instance::impl::shutdown() {
+
+        if (!is_init)
+            DEBUG_BREAK("logger::shutdown() was called bevor logger was initalized")
+
+        is_init = false;                    // reject new messages, everything already queued is still processed
+
+        {
+            std::lock_guard<std::mutex> lock(live_instances_mutex);
+            std::erase(live_instances, this);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        cv->notify_all();
+
+#ifdef __linux__
+        if (config_thread) {
+
+            const u64 wakeup = 1;
+            [[maybe_unused]] const ssize_t written = write(config_wakeup_fd, &wakeup, sizeof(wakeup));
+            config_thread->join();
+            config_thread.reset();
+            close(config_wakeup_fd);
+            config_wakeup_fd = -1;
+        }
+#endif
+
+        if (worker_thread) {
+            worker_thread->join();
+            worker_thread.reset();
+        }
+
+        {   // the worker already wrote all chunks
+            std::lock_guard<std::mutex> lock(formatter_mutex);
+            formatter_stop = true;
+        }
+        formatter_cv->notify_all();
+        for (const std::unique_ptr<std::thread>& formatter : formatter_pool)
+            formatter->join();
+        formatter_pool.clear();
+
+        if (!socket_path.empty())
+            socket_shutdown();
+
+        console.stop();
+
+        {   // nothing triggered the remaining backtrace, discard it
+            std::lock_guard<std::mutex> lock(backtrace_mutex);
+            global_backtrace.messages.clear();
+        }
+
+        {   // commands that arrived after the worker finished
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            for (; !control_queue.empty(); control_queue.pop())
+                if (control_queue.front().barrier)
+                    control_queue.front().barrier->set_value();
+        }
+
+        if (index_block_size > 0) {
+
+            {
+                std::lock_guard<std::mutex> lock(general_mutex);
+                index_close_block(index_counter.position());
+            }
+            index_write_pending();
+            index_file.close();
+            index_block_size = 0;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(general_mutex);
+            for (auto& [thread_id, file] : thread_files) {
+
+                std::lock_guard<std::mutex> file_lock(file->mutex);
+                file->file.close();
+                file->closed = true;
+            }
+            thread_files.clear();
+            thread_files_generation++;
+        }
+
+        if (compressor.is_open()) {
+
+            std::lock_guard<std::mutex> lock(general_mutex);
+            compressor.finish();
+            unsynced_data = true;
+        }
+
+        if (durability_mode != durability::none && unsynced_data)
+            sync_main_file(false);
+
+#ifdef __unix__
+        if (main_file_sync_fd >= 0) {
+            close(main_file_sync_fd);
+            main_file_sync_fd = -1;
+        }
+#endif
+
+        if (main_file.is_open())
+            CLOSE_MAIN_FILE()
+
+        if (shared_buffer.is_open()) {
+
+            main_file.flush();
+            shared_buffer.close_file();
+            static_cast<std::ostream&>(main_file).rdbuf(main_file.rdbuf());
+        }
+
+        std::cout << "[LOGGER] Performance of [" << main_log_file_path.string() << "]" << std::endl;
+#ifdef TIME_FORMATTER_PERFORMANCE
+        std::cout << std::left << std::setw(40) << "[LOGGER] Formatting performance:" << " counter [" << std::setw(8) << formatting_counter << "] average time[" << cumulative_formatting_duration / formatting_counter << " micro-s]" << std::endl;
+#endif
+#ifdef TIME_COUT_PERFORMANCE
+        std::cout << std::left << std::setw(40) << "[LOGGER] Cout performance:" << " counter [" << std::setw(8) << cout_counter << "] average time[" << cumulative_cout_duration / cout_counter << " micro-s]" << std::endl;
+#endif
+#ifdef TIME_QUEUE_ADDING_PERFORMANCE
+        std::cout << std::left << std::setw(40) << "[LOGGER] Queue performance:" << " counter [" << std::setw(8) << queue_adding_counter << "] average time[" << cumulative_queue_adding_duration / queue_adding_counter << " micro-s]" << std::endl;
+#endif
+#ifdef TIME_WRITING_TO_FILE_PERFORMANCE
+        std::cout << std::left << std::setw(40) << "[LOGGER] writing to file performance:" << " counter [" << std::setw(8) << writing_to_file_counter << "] average time[" << cumulative_writing_to_file_duration / writing_to_file_counter << " micro-s]" << std::endl;
+#endif
+
+#ifdef TIME_END_TO_END_PERFORMANCE
+        std::cout << std::left << std::setw(40) << "[LOGGER] end-to-end latency:" << " counter [" << std::setw(8) << end_to_end_counter << "] average time[" << cumulative_end_to_end_duration / end_to_end_counter << " micro-s] max[" << max_end_to_end_duration << " micro-s]" << std::endl;
+#endif
+
+        if (compressor.input_bytes > 0)
+            std::cout << std::left << std::setw(40) << "[LOGGER] compression:" << " counter [" << std::setw(8) << compressor.compress_counter << "] average time[" << compressor.cumulative_compress_duration / compressor.compress_counter
+                      << " micro-s] ratio[" << static_cast<f32>(compressor.input_bytes) / std::max<u64>(compressor.output_bytes, 1) << "]" << std::endl;
+
+        if (!socket_path.empty())
+            std::cout << std::left << std::setw(40) << "[LOGGER] socket sink:" << " sent [" << socket_sent_records << "] dropped [" << socket_dropped_records << "]" << std::endl;
+
+        if (console.dropped_messages() > 0)
+            std::cout << std::left << std::setw(40) << "[LOGGER] console:" << " dropped [" << console.dropped_messages() << "] messages" << std::endl;
+
+#ifdef TIME_MAIN_THREAD_PERFORMANCE
+        std::cout << std::left << std::setw(40) << "[LOGGER] main-thread logger performance:" << " counter [" << std::setw(8) << main_thread_counter << "] average time[" << cumulative_main_thread_duration / main_thread_counter << " micro-s]" << std::endl;
+#endif
+    }
+
+    // ====================================================================================================================================
+    // settings
+    // ====================================================================================================================================
+
+    void instance::impl::set_format(const std::string& new_format) {        // needed to insert this into the queue to preserve the order
+
+        if (!is_init) {
+        
+    		std::cerr << "Tryed to set logger format bevor logger was initalized" << std::endl;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        control_queue.push({ control_type::set_format, next_sequence, new_format, nullptr });
+        work_counter.fetch_add(1, std::memory_order_release);
+        cv->notify_all();
+    }
+
+    void instance::impl::use_previous_format() {
+        
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        control_queue.push({ control_type::reverse_format, next_sequence, "", nullptr });
+        work_counter.fetch_add(1, std::memory_order_release);
+        cv->notify_all();
+    }
+
+    std::future<void> instance::impl::flush_async() {
+
+        auto barrier = std::make_shared<std::promise<void>>();
+        std::future<void> result = barrier->get_future();
+        if (!is_init) {
+
+            barrier->set_value();
+            return result;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            control_queue.push({ control_type::flush, next_sequence, "", std::move(barrier) });
+            work_counter.fetch_add(1, std::memory_order_release);
+        }
+        cv->notify_all();
+        return result;
+    }
+
+    void instance::impl::register_label_for_thread(const std::string& thread_lable, std::thread::id thread_id) {
+
+        std::lock_guard<std::mutex> lock(general_mutex);
+
+        if (thread_lable_map.find(thread_id) != thread_lable_map.end())
+            main_file << "[LOGGER] Thread with ID: [" << thread_id << "] already has lable [" << thread_lable_map[thread_id] << "] registered. Overriding with the lable: [" << thread_lable << "]\n";
+        else
+            main_file << "[LOGGER] Registering Thread-ID: [" << thread_id << "] with the lable: [" << thread_lable << "]\n";
+
+        thread_lable_map[thread_id] = thread_lable;
+        thread_lable_snapshot = std::make_shared<const lable_map>(thread_lable_map);
+        if (per_thread_files && is_init)
+            open_thread_file(thread_lable, thread_id);
+    }
+
+    void instance::impl::unregister_label_for_thread(std::thread::id thread_id) {
+
+        if (thread_lable_map.find(thread_id) == thread_lable_map.end()) {
+
+            std::lock_guard<std::mutex> lock(general_mutex);
+            main_file << "[LOGGER] Tried to unregister lable for Thread-ID: [" << thread_id << "]. IGNORED\n";
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(general_mutex);
+        main_file << "[LOGGER] Unregistering Thread-ID: [" << thread_id << "] with the lable: [" << thread_lable_map[thread_id] << "]\n";
+
+        thread_lable_map.erase(thread_id);
+        thread_lable_snapshot = std::make_shared<const lable_map>(thread_lable_map);
+        if (thread_files.erase(thread_id) > 0)
+            thread_files_generation++;
+    }
+
+    // ====================================================================================================================================
+    // stack traces
+    // ====================================================================================================================================
+
+    // called on the logging thread, only the raw return addresses are stored. noinline so frame 0 is always this function
+    // @param depth Max number of frames, without the frames of the logger itself (the leading logger frames are skipped by write_stack_trace())
+    [[gnu::noinline]] static std::shared_ptr<const std::vector<void*>> capture_stack_trace(const u32 depth) {
+
+#ifdef __linux__
+        // this function & at least one caller in logger.cpp (the entry point called by LOG() is never inlined into the user code)
+        constexpr int min_logger_frames = 2;
+        constexpr int max_logger_frames = 8;                        // longer than the call chain from logger::log_msg() to here
+        std::vector<void*> frames(depth + max_logger_frames);
+        const int frame_count = ::backtrace(frames.data(), static_cast<int>(frames.size()));
+        if (frame_count <= min_logger_frames)
+            return {};
+
+        frames.resize(static_cast<size_t>(frame_count));
+        frames.erase(frames.begin(), frames.begin() + min_logger_frames);
+        return std::make_shared<const std::vector<void*>>(std::move(frames));
+#else
+        (void)depth;
+        return {};
+#endif
+    }
+
+    // symbolize [frames] (called when formatting, on the worker / formatter threads)
+    // the rest of the logger chain (submit_message, impl/instance::log_msg, logger::log_msg) depends on inlining & the entry point,
+    // every leading frame in namespace logger is skipped (without a symbol name, no -rdynamic, nothing is skipped), then at most [depth] frames are written
+    // every frame is written in its own line: "    #<index>  <symbol>+<offset>  [<module>+<offset in module>]"
+    static void write_stack_trace(std::ostringstream& output, const std::vector<void*>& frames, const u32 depth) {
+
+#ifdef __linux__
+        size_t first_user_frame = 0;
+        for (Dl_info info{}; first_user_frame < frames.size(); first_user_frame++)
+            if (dladdr(frames[first_user_frame], &info) == 0 || info.dli_sname == nullptr || std::strncmp(info.dli_sname, "_ZN6logger", 10) != 0)
+                break;
+
+        const size_t frame_count = std::min<size_t>(frames.size() - first_user_frame, depth);
+        for (size_t x = 0; x < frame_count; x++) {
+
+            void* const frame = frames[first_user_frame + x];
+            output << "\n    #" << x << "  ";
+            Dl_info info{};
+            if (dladdr(frame, &info) == 0) {
+                output << "??  [" << frame << "]";
+                continue;
+            }
+
+            if (info.dli_sname != nullptr) {
+
+                int status = 0;
+                char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                output << ((status == 0 && demangled != nullptr) ? demangled : info.dli_sname) << "+0x" << std::hex << (reinterpret_cast<uintptr_t>(frame) - reinterpret_cast<uintptr_t>(info.dli_saddr)) << std::dec;
+                std::free(demangled);
+            } else
+                output << "??";
+
+            output << "  [" << ((info.dli_fname != nullptr) ? info.dli_fname : "??") << "+0x" << std::hex << (reinterpret_cast<uintptr_t>(frame) - reinterpret_cast<uintptr_t>(info.dli_fbase)) << std::dec << "]";
+        }
+#else
+        (void)output;
+        (void)frames;
+        (void)depth;
+#endif
+    }
+
+    // ====================================================================================================================================
+    // logging context (scoped_context)
+    // ====================================================================================================================================
+
+    static thread_local std::shared_ptr<const context_node>    current_context{};
+
+    scoped_context::scoped_context(std::string key, std::string value)
+        : m_previous(current_context) {
+
+        current_context = std::make_shared<const context_node>(context_node{ std::move(key), std::move(value), current_context });
+    }
+
+    scoped_context::scoped_context(const context_snapshot& snapshot)
+        : m_previous(std::move(current_context)) {
+
+        current_context = snapshot.node;
+    }
+
+    scoped_context::~scoped_context()                                                                           { current_context = std::move(m_previous); }
+
+    context_snapshot capture_context()                                                                          { return { current_context }; }
+
+    // "key=value key=value", outermost scope first
+    static void write_context(std::ostringstream& output, const context_node* node) {
+
+        if (node->parent) {
+
+            write_context(output, node->parent.get());
+            output << ' ';
+        }
+        output << node->key << '=' << node->value;
+    }
+
+    // ====================================================================================================================================
+    // log message handeling
+    // ====================================================================================================================================
+
+    void instance::impl::process_update_in_msg_format(const std::string& new_format) {
+
+        std::lock_guard<std::mutex> lock(general_mutex);
+        format_prev = format_current;
+        format_current = new_format;
+        config_version++;
+        main_file << "[LOGGER] Changing log-format. From [" << format_prev << "] to [" << format_current << "]\n";
+    }
+
+    void instance::impl::process_reverse_in_msg_format() {
+
+        std::lock_guard<std::mutex> lock(general_mutex);
+        const std::string buffer = format_current;
+        format_current = format_prev;
+        format_prev = buffer;
+        config_version++;
+        main_file << "[LOGGER] Changing to previous log-format. From [" << format_prev << "] to [" << format_current << "]\n";
+    }
+
+    void instance::impl::process_control_message(control_message&& control) {
+
+        switch (control.type) {
+            case control_type::set_format:      process_update_in_msg_format(control.format); break;
+            case control_type::reverse_format:  process_reverse_in_msg_format(); break;
+            case control_type::backtrace: {
+
+                std::lock_guard<std::mutex> lock(general_mutex);
+                main_file << control.format;
+            }
+            break;
+            case control_type::flush: {
+
+                if (index_block_size > 0)
+                    index_write_pending();
+                if (!socket_path.empty()) {
+                    std::lock_guard<std::mutex> socket_lock(socket_mutex);
+                    socket_end_batch();
+                }
+                sync_main_file(true);
+
+                std::lock_guard<std::mutex> lock(general_mutex);
+                for (auto& [thread_id, file] : thread_files) {
+
+                    std::lock_guard<std::mutex> file_lock(file->mutex);
+                    file->file.flush();
+                }
+            }
+            control.barrier->set_value();
+            break;
+        }
+    }
+
+    // @return [main_file_sync_fd], opened on the first call so init() doesn't pay for it. Called while holding [general_mutex]
+    int instance::impl::open_sync_descriptor() {
+
+#ifdef __unix__
+        if (main_file_sync_fd < 0)
+            main_file_sync_fd = open(main_log_file_path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+        return main_file_sync_fd;
+    }
+
+    // flush [main_file] to the OS and force it onto the disk
+    // @param data_only Use fdatasync() instead of fsync() (skips metadata like the modification time)
+    void instance::impl::sync_main_file(const bool data_only) {
+
+        int sync_fd = -1;
+        {
+            std::lock_guard<std::mutex> file_lock(general_mutex);
+            main_file.flush();
+            sync_fd = open_sync_descriptor();
+        }
+
+#ifdef __unix__
+        if (sync_fd >= 0) {
+            if (data_only)
+                fdatasync(sync_fd);
+            else
+                fsync(sync_fd);
+        }
+#endif
+        unsynced_data = false;
+    }
+
+    // called by the worker after the queue is drained
+    void instance::impl::process_batch_end() {
+
+        console.wake();
+
+        if (!socket_path.empty()) {
+            std::lock_guard<std::mutex> socket_lock(socket_mutex);
+            socket_end_batch();
+        }
+
+        if (call_site_report_interval.count() > 0 && std::chrono::steady_clock::now() >= next_call_site_report) {
+
+            write_call_site_report();
+            next_call_site_report = std::chrono::steady_clock::now() + call_site_report_interval;
+        }
+
+        if (index_block_size > 0)
+            index_write_pending();
+
+        if (compressor.is_open() && compressor.unflushed && std::chrono::steady_clock::now() >= next_compression_flush) {
+
+            std::lock_guard<std::mutex> file_lock(general_mutex);
+            main_file.flush();                                      // sync-flush point, readable with zcat from here on
+            next_compression_flush = std::chrono::steady_clock::now() + compression_flush_interval;
+        }
+
+        if (!unsynced_data)
+            return;
+
+        if (shared_buffer.is_open()) {                              // the batch goes into the file as a few whole-record writes
+
+            std::lock_guard<std::mutex> file_lock(general_mutex);
+            main_file.flush();
+        }
+
+        if (durability_mode == durability::fdatasync_per_batch)
+            sync_main_file(true);
+        else if (durability_mode == durability::fsync_interval && std::chrono::steady_clock::now() >= next_sync) {
+
+            sync_main_file(false);
+            next_sync = std::chrono::steady_clock::now() + fsync_interval;
+        }
+        else if (flush_each_batch) {
+
+            std::lock_guard<std::mutex> file_lock(general_mutex);
+            main_file.flush();
+        }
+    }
+
+    // Wait until there is a message or command in the queue, a new config, a pending fsync or stop is signaled.
+    // [lock] is held on entry and exit, returning without work is allowed (e.g. fsync interval elapsed)
+    void instance::impl::wait_for_work(std::unique_lock<std::mutex>& lock) {
+
+        const auto has_work = [this] { return !log_queue.empty() || !control_queue.empty() || stop || config_pending || fork_pending; };
+        if (has_work())
+            return;
+
+        // next pending fsync or sync-flush point of the compressor
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        if (durability_mode == durability::fsync_interval && unsynced_data)
+            deadline = next_sync;
+        if (compressor.is_open() && compressor.unflushed)
+            deadline = std::min(deadline, next_compression_flush);
+        if (!socket_path.empty()) {
+
+            std::lock_guard<std::mutex> socket_lock(socket_mutex);
+            if (!socket_pending.empty())
+                deadline = std::min(deadline, next_socket_attempt);        // reconnect or retry a full socket
+        }
+        const bool sync_pending = deadline != std::chrono::steady_clock::time_point::max();
+        if (worker_wait_strategy != wait_strategy::block) {
+
+            const u64 seen_work = work_counter.load(std::memory_order_relaxed);
+            lock.unlock();
+            for (u32 spins = 0; work_counter.load(std::memory_order_acquire) == seen_work && !stop; spins++) {
+
+                if (worker_wait_strategy == wait_strategy::spin_then_park && spins >= spin_budget)
+                    break;
+
+                if (sync_pending && (spins & 0x3FF) == 0 && std::chrono::steady_clock::now() >= deadline)
+                    break;
+
+                if (worker_wait_strategy == wait_strategy::yield)
+                    std::this_thread::yield();
+                else
+                    CPU_RELAX();
+            }
+            lock.lock();
+
+            if (has_work() || worker_wait_strategy != wait_strategy::spin_then_park)
+                return;                 // yield & busy_poll never park
+        }
+
+        worker_parked = true;
+        if (sync_pending)
+            cv->wait_until(lock, deadline, has_work);
+        else
+            cv->wait(lock, has_work);
+        worker_parked = false;
+    }
+
+    // pin the worker to a CPU core and/or change its scheduling priority, failures are noted in the main file
+    void instance::impl::setup_worker_thread(const init_options& options) {
+
+        std::lock_guard<std::mutex> lock(general_mutex);
+#ifdef __linux__
+        if (options.worker_cpu >= 0) {
+
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(options.worker_cpu, &cpu_set);
+            if (pthread_setaffinity_np(worker_thread->native_handle(), sizeof(cpu_set), &cpu_set) != 0)
+                main_file << "[LOGGER] FAILED to pin worker thread to CPU [" << options.worker_cpu << "]\n";
+        }
+
+        if (options.worker_sched_priority > 0) {
+
+            sched_param param{};
+            param.sched_priority = options.worker_sched_priority;
+            if (pthread_setschedparam(worker_thread->native_handle(), SCHED_FIFO, &param) != 0)
+                main_file << "[LOGGER] FAILED to set SCHED_FIFO priority [" << options.worker_sched_priority << "] for worker thread (needs CAP_SYS_NICE)\n";
+        }
+#else
+        if (options.worker_cpu >= 0 || options.worker_sched_priority > 0)
+            main_file << "[LOGGER] Worker CPU pinning and priority are only supported on Linux. IGNORED\n";
+#endif
+    }
+
+    void instance::impl::process_queue() {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        worker_running = true;
+        while (true) {
+            wait_for_work(lock);
+            if (fork_pending)
+                pause_for_fork(lock);
+
+            // batch boundary: apply a reloaded config file bevor the next batch
+            if (config_pending) {
+
+                std::unique_ptr<runtime_config> config = std::move(pending_config);
+                config_pending = false;
+                lock.unlock();
+                if (config)
+                    apply_config(std::move(*config));
+                lock.lock();
+            }
+    
+            // Process all messages in the queue, commands are executed at their position between the messages
+            while (true) {
+
+                if (fork_pending)
+                    pause_for_fork(lock);
+
+                const u64 limit = (control_queue.empty()) ? UINT64_MAX : control_queue.front().position;
+                message_queue* lane = log_queue.next(limit);
+                if (lane == nullptr && !control_queue.empty()) {
+
+                    control_message control = std::move(control_queue.front());
+                    control_queue.pop();
+                    lock.unlock();
+                    write_format_chunks(0);                 // everything bevor the command has to be written
+                    process_control_message(std::move(control));
+                    lock.lock();
+                    continue;
+                }
+
+                if (lane == nullptr)
+                    break;
+
+                if (!formatter_pool.empty()) {
+
+                    // cut the next chunk, it never reaches past the position of the next command
+                    auto chunk = std::make_unique<format_chunk>();
+                    chunk->messages.reserve(std::min<size_t>(log_queue.size(), formatter_chunk_size));
+                    for (; lane != nullptr && chunk->messages.size() < formatter_chunk_size; lane = log_queue.next(limit))
+                        chunk->messages.push_back(log_queue.take(*lane));
+                    lock.unlock();
+
+                    dispatch_format_chunk(std::move(chunk));
+                    write_format_chunks(max_chunks_in_flight);
+
+                    lock.lock();
+                    continue;
+                }
+
+                // Get message from queue
+                message_format message = log_queue.take(*lane);
+                lock.unlock(); // Unlock while processing the message
+    
+                process_log_message(std::move(message));
+    
+                lock.lock(); // Re-lock for the next iteration
+            }
+
+            // batch boundary: the queue is drained
+            lock.unlock();
+            write_format_chunks(0);
+            process_batch_end();
+            lock.lock();
+
+            // checked after the drain, the queue was unlocked while writing the batch so messages (and shutdown()) may have arrived in the meantime
+            if (stop && log_queue.empty() && control_queue.empty())
+                break;
+        }
+        worker_running = false;
+        fork_cv->notify_all();
+
+        if (call_site_report_interval.count() > 0)
+            write_call_site_report();
+    }
+
+    // top call sites by volume (init_options::call_site_report_interval_ms), written into the main file by the worker. Skipped if nothing was logged since the last one
+    void instance::impl::write_call_site_report() {
+
+        const std::vector<call_site_stats> call_sites = profiler.collect(0);
+        u64 total_bytes = 0;
+        for (const call_site_stats& site : call_sites)
+            total_bytes += site.bytes;
+        if (total_bytes == call_site_report_bytes)                  // nothing logged since the last report (e.g. an interval report right bevor shutdown)
+            return;
+
+        call_site_report_bytes = total_bytes;
+
+        std::ostringstream report;
+        report << "[LOGGER] ---------- top " << std::min<size_t>(call_site_report_count, call_sites.size()) << " of " << call_sites.size() << " call sites by volume ----------\n";
+        for (size_t x = 0; x < call_sites.size() && x < call_site_report_count; x++) {
+
+            const call_site_stats& site = call_sites[x];
+            report << "[LOGGER] " << std::fixed << std::setprecision(1) << std::setw(5) << (100.0 * site.bytes / total_bytes) << "%  "
+                   << std::setw(10) << site.bytes << " bytes  " << std::setw(9) << site.messages << " messages  "
+                   << std::setprecision(3) << site.average_formatting_time << " micro-s/message  "
+                   << get_filename(site.file_name.c_str()) << ":" << site.line << " " << site.function_name << "()\n";
+        }
+        report << "[LOGGER] ---------- end of call sites ----------\n";
+
+        std::lock_guard<std::mutex> file_lock(general_mutex);
+        main_file << report.view();
+        if (shared_buffer.is_open())
+            shared_buffer.end_record();
+        unsynced_data = true;
+    }
+
+    void instance::impl::log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, std::string&& message) {
+
+        if (accept_message(msg_sev, file_name, function_name, line, thread_id, message))
+            submit_message(message_format(msg_sev, file_name, function_name, line, thread_id, std::move(message)));
+    }
+
+    void instance::impl::log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const static_text message) {
+
+        if (accept_message(msg_sev, file_name, function_name, line, thread_id, message.text))
+            submit_message(message_format(msg_sev, file_name, function_name, line, thread_id, message));
+    }
+
+    // checks that are done bevor the message is created
+    bool instance::impl::accept_message(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const std::string_view message) {
+
+        if (message.empty())
+            return false;                // dont log empty lines
+
+        if (static_cast<u8>(msg_sev) < lowest_level.load(std::memory_order_relaxed))
+            return false;                // disabled by the runtime levels of the config file
+
+        if (!is_init) {
+
+    		std::cerr << "Tryed to log message bevor logger was initalized. SOURCE: file_name[" << file_name << "] function_name[" << function_name << "] line[" << line << "] thread_id[" << thread_id << "]  MESSAGE: [" << message << "] " << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // the message is only moved from here on, for a static_text nothing is allocated on the way into [log_queue]
+    void instance::impl::submit_message(message_format&& message) {
+
+        if (current_context)
+            message.context = current_context;                      // reference count only
+
+        if (stack_trace_depth > 0 && message.msg_sev >= stack_trace_level)
+            message.stack_trace = capture_stack_trace(stack_trace_depth);
+
+        std::optional<std::deque<message_format>> backtrace{};      // an empty std::deque already allocates
+        if (backtrace_size > 0) {
+
+            if (message.msg_sev < backtrace_level) {
+
+                record_backtrace(std::move(message));
+                return;
+            }
+
+            if (message.msg_sev >= backtrace_trigger)
+                backtrace = take_backtrace();
+        }
+
+        if (per_thread_files && message.thread_id == std::this_thread::get_id()) {
+
+            const std::shared_ptr<thread_file> file = get_thread_file();
+            if (file) {
+
+                if (backtrace)
+                    for (const message_format& entry : *backtrace)
+                        write_thread_file(*file, entry);
+                write_thread_file(*file, message);
+                return;
+            }
+        }
+
+        if (synchronous_errors && message.msg_sev >= severity::Error) {
+
+            write_message_now(std::move(message), (backtrace) ? &*backtrace : nullptr);
+            return;
+        }
+
+        START_QUEUE_ADDING_TIMER
+        bool wake_worker = false;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (backtrace && !backtrace->empty())
+                push_backtrace(std::move(*backtrace));
+            enqueue_message(std::move(message));
+            work_counter.fetch_add(1, std::memory_order_release);
+            wake_worker = worker_parked;
+        }
+        if (wake_worker)                // skip the futex syscall while the worker is awake
+            cv->notify_one();
+        END_QUEUE_ADDING_TIMER
+    }
+
+    // called while holding [queue_mutex]
+    void instance::impl::enqueue_message(message_format&& message) {
+
+        message.sequence = next_sequence++;
+        log_queue.push(std::move(message), (priority_lanes) ? log_lanes::lane_of(message.msg_sev) : 0);
+    }
+
+    // init_options::synchronous_errors: format & write the message on the calling thread, it doesn't wait behind the queue.
+    // A [backtrace] triggered by the message is written right bevor it (framed like push_backtrace() does it), so the context stays in front
+    void instance::impl::write_message_now(message_format&& message, std::deque<message_format>* backtrace) {
+
+        const bool has_backtrace = backtrace != nullptr && !backtrace->empty();
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (has_backtrace)
+                for (message_format& entry : *backtrace)
+                    entry.sequence = next_sequence++;
+            message.sequence = next_sequence++;
+        }
+
+        // the records also go to the socket sink, in the same order as in the file. [socket_mutex] is taken bevor [general_mutex]
+        // and the records are added after it's released (a (dis)connect of the sink is noted in the main file)
+        std::unique_lock<std::mutex> socket_lock(socket_mutex, std::defer_lock);
+        if (!socket_path.empty())
+            socket_lock.lock();
+        std::vector<std::pair<const message_format*, std::string>> socket_records;
+
+        std::string console_output;
+        int sync_fd = -1;
+        {
+            std::lock_guard<std::mutex> file_lock(general_mutex);
+            const auto write_entry = [&](const message_format& entry) {
+
+                const auto lable = thread_lable_map.find(entry.thread_id);
+                const std::string* thread_lable = (lable != thread_lable_map.end()) ? &lable->second : nullptr;
+                if (!levels->enabled(entry, thread_lable))
+                    return;
+
+                std::ostringstream Format_Filled;
+                const auto formatting_start = (profile_call_sites) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+                format_message(Format_Filled, format_current, entry, thread_lable, stack_trace_depth);
+                if (profile_call_sites)
+                    profiler.record(entry, Format_Filled.view().size(), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - formatting_start).count());
+
+                main_file << Format_Filled.view();
+                if (shared_buffer.is_open())
+                    shared_buffer.end_record();
+                if (index_block_size > 0)
+                    index_add_message(entry, Format_Filled.view().size());
+                if (write_logs_to_console)
+                    console_output += Format_Filled.view();
+                if (socket_lock.owns_lock())
+                    socket_records.emplace_back(&entry, Format_Filled.str());
+            };
+
+            if (has_backtrace) {
+
+                std::ostringstream header;
+                header << "[LOGGER] ---------- backtrace: last " << backtrace->size() << " messages below [" << severity_names[static_cast<u8>(backtrace_level)] << "] ----------\n";
+                main_file << header.view();
+                if (write_logs_to_console)
+                    console_output += header.view();
+
+                for (const message_format& entry : *backtrace)
+                    write_entry(entry);
+
+                const std::string_view footer = "[LOGGER] ---------- end of backtrace ----------\n";
+                main_file << footer;
+                if (write_logs_to_console)
+                    console_output += footer;
+            }
+
+            write_entry(message);
+            main_file.flush();                                      // the OS has it (a sync-flush point for compressed files)
+            if (durability_mode != durability::none)
+                sync_fd = open_sync_descriptor();
+        }
+
+        if (socket_lock.owns_lock()) {                              // sent right away, what the collector can't take now is sent with the next batch of the worker
+
+            for (const auto& [entry, formatted_message] : socket_records)
+                socket_add_record(*entry, formatted_message);
+            socket_end_batch();
+            socket_lock.unlock();
+        }
+
+#ifdef __unix__
+        if (sync_fd >= 0)
+            fsync(sync_fd);
+#else
+        (void)sync_fd;
+#endif
+
+        if (!console_output.empty())
+            console.write_now(console_output);
+    }
+
+    // ====================================================================================================================================
+    // backtrace
+    // ====================================================================================================================================
+
+    void instance::impl::record_backtrace(message_format&& message) {
+
+        std::unique_lock<std::mutex> lock(backtrace_mutex, std::defer_lock);
+        backtrace_ring* ring = &global_backtrace;
+        if (backtrace_per_thread) {
+
+            ring = &local_backtraces[instance_id];
+            if (ring->generation != backtrace_generation) {
+
+                ring->messages.clear();
+                ring->generation = backtrace_generation;
+            }
+        } else
+            lock.lock();
+
+        if (ring->messages.size() >= backtrace_size)
+            ring->messages.pop_front();
+        ring->messages.push_back(std::move(message));
+    }
+
+    // remove and return the content of the ring of the calling thread (or the global ring)
+    std::deque<message_format> instance::impl::take_backtrace() {
+
+        std::deque<message_format> result{};
+        if (backtrace_per_thread) {
+
+            const auto ring = local_backtraces.find(instance_id);
+            if (ring != local_backtraces.end() && ring->second.generation == backtrace_generation)
+                result.swap(ring->second.messages);
+            return result;
+        }
+
+        std::lock_guard<std::mutex> lock(backtrace_mutex);
+        result.swap(global_backtrace.messages);
+        return result;
+    }
+
+    // enqueue [backtrace] framed by two lines in the main file, called while holding [queue_mutex]
+    void instance::impl::push_backtrace(std::deque<message_format>&& backtrace) {
+
+        std::ostringstream header;
+        header << "[LOGGER] ---------- backtrace: last " << backtrace.size() << " messages below [" << severity_names[static_cast<u8>(backtrace_level)] << "] ----------\n";
+        control_queue.push({ control_type::backtrace, next_sequence, header.str(), nullptr });
+
+        for (message_format& message : backtrace)
+            enqueue_message(std::move(message));
+
+        control_queue.push({ control_type::backtrace, next_sequence, "[LOGGER] ---------- end of backtrace ----------\n", nullptr });
+        work_counter.fetch_add(2, std::memory_order_release);
+    }
+
+    void instance::impl::dump_backtrace() {
+
+        if (!is_init || backtrace_size == 0)
+            return;
+
+        std::deque<message_format> backtrace = take_backtrace();
+        if (backtrace.empty())
+            return;
+
+        bool wake_worker = false;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            push_backtrace(std::move(backtrace));
+            wake_worker = worker_parked;
+        }
+        if (wake_worker)
+            cv->notify_one();
+    }
+
+    void instance::impl::process_log_message(const message_format&& message) {
+
+        START_FORMATTING_TIMER
+
+        // Create Buffer vars
+        std::ostringstream Format_Filled;
+        Format_Filled.flush();
+
+        const auto lable = thread_lable_map.find(message.thread_id);
+        const std::string* thread_lable = (lable != thread_lable_map.end()) ? &lable->second : nullptr;
+        if (!levels->enabled(message, thread_lable))
+            return;
+
+        const auto formatting_start = (profile_call_sites) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+        format_message(Format_Filled, format_current, message, thread_lable, stack_trace_depth);
+        if (profile_call_sites)
+            profiler.record(message, Format_Filled.view().size(), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - formatting_start).count());
+
+        END_FORMATTING_TIMER
+
+        {
+#ifdef TIME_WRITING_TO_FILE_PERFORMANCE            
+            START_TIMER(writing_to_file)
+#endif
+            std::lock_guard<std::mutex> file_lock(general_mutex);
+            main_file << Format_Filled.view();
+            if (shared_buffer.is_open())
+                shared_buffer.end_record();
+            unsynced_data = true;
+            if (index_block_size > 0)
+                index_add_message(message, Format_Filled.view().size());
+
+#ifdef TIME_WRITING_TO_FILE_PERFORMANCE
+            END_TIMER(writing_to_file)
+#endif
+        }
+
+        if (!socket_path.empty()) {
+            std::lock_guard<std::mutex> socket_lock(socket_mutex);
+            socket_add_record(message, Format_Filled.view());
+        }
+
+#ifdef TIME_END_TO_END_PERFORMANCE
+        const f32 end_to_end_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now() - message.timestamp).count() / 1000.f;
+        cumulative_end_to_end_duration += end_to_end_duration;
+        max_end_to_end_duration = std::max(max_end_to_end_duration, end_to_end_duration);
+        end_to_end_counter++;
+#endif
+
+        if (durability_mode == durability::fsync_on_error && message.msg_sev >= severity::Error)
+            sync_main_file(false);
+
+        if (write_logs_to_console) {
+
+            START_COUT_TIMER
+            console.append(Format_Filled.view());
+            END_COUT_TIMER
+        }
+
+    }
+
+    // ====================================================================================================================================
+    // formatter pool
+    // ====================================================================================================================================
+
+    // format all messages of [chunk] into [chunk.output], can run on any thread
+    void format_chunk_messages(format_chunk& chunk) {
+
+        util::stopwatch loc_stopwatch(&chunk.formatting_duration, util::duration_precision::microseconds);
+
+        std::ostringstream Format_Filled;
+        chunk.message_sizes.reserve(chunk.messages.size());
+        for (const message_format& message : chunk.messages) {
+
+            const auto lable = chunk.thread_lables->find(message.thread_id);
+            const std::string* thread_lable = (lable != chunk.thread_lables->end()) ? &lable->second : nullptr;
+            if (!chunk.levels->enabled(message, thread_lable)) {
+
+                chunk.message_sizes.push_back(0);
+                continue;
+            }
+
+            Format_Filled.str("");
+            const auto formatting_start = (chunk.profiler != nullptr) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+            format_message(Format_Filled, chunk.format, message, thread_lable, chunk.stack_trace_depth);
+            if (chunk.profiler != nullptr)
+                chunk.profiler->record(message, Format_Filled.view().size(), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - formatting_start).count());
+            const size_t size_bevor = chunk.output.size();
+            chunk.output += Format_Filled.view();
+            chunk.message_sizes.push_back(static_cast<u32>(chunk.output.size() - size_bevor));
+        }
+    }
+
+    void instance::impl::run_formatter() {
+
+        std::unique_lock<std::mutex> lock(formatter_mutex);
+        while (true) {
+
+            formatter_cv->wait(lock, [this] { return !formatter_jobs.empty() || formatter_stop; });
+            if (formatter_jobs.empty())
+                return;                                 // [formatter_stop]
+
+            format_chunk* chunk = formatter_jobs.front();
+            formatter_jobs.pop_front();
+            lock.unlock();
+            format_chunk_messages(*chunk);
+            lock.lock();
+
+            chunk->ready = true;
+            formatter_done_cv->notify_one();
+        }
+    }
+
+    // called by the worker, takes a copy of the current format, levels and thread lables
+    void instance::impl::dispatch_format_chunk(std::unique_ptr<format_chunk>&& chunk) {
+
+        {
+            std::lock_guard<std::mutex> lock(general_mutex);
+            chunk->format = format_current;
+            chunk->thread_lables = thread_lable_snapshot;
+        }
+        chunk->levels = levels;
+        chunk->profiler = (profile_call_sites) ? &profiler : nullptr;
+        chunk->stack_trace_depth = stack_trace_depth;
+
+        {
+            std::lock_guard<std::mutex> lock(formatter_mutex);
+            formatter_jobs.push_back(chunk.get());
+        }
+        formatter_cv->notify_one();
+        chunks_in_flight.push_back(std::move(chunk));
+    }
+
+    // write finished chunks in the order they were cut, waits for the oldest chunk while more than [max_in_flight] are pending.
+    // While waiting the worker formats pending chunks itself instead of sleeping
+    void instance::impl::write_format_chunks(const size_t max_in_flight) {
+
+        while (!chunks_in_flight.empty()) {
+
+            format_chunk& chunk = *chunks_in_flight.front();
+            {
+                std::unique_lock<std::mutex> lock(formatter_mutex);
+                while (!chunk.ready) {
+
+                    if (chunks_in_flight.size() <= max_in_flight)
+                        return;
+
+                    if (formatter_jobs.empty()) {
+                        formatter_done_cv->wait(lock);
+                        continue;
+                    }
+
+                    format_chunk* job = formatter_jobs.front();
+                    formatter_jobs.pop_front();
+                    lock.unlock();
+                    format_chunk_messages(*job);
+                    lock.lock();
+                    job->ready = true;
+                }
+            }
+
+            write_format_chunk(chunk);
+            chunks_in_flight.pop_front();
+        }
+    }
+
+    // @note With fsync_on_error the main file is synced after the chunk that contains the error, not directly after the message
+    void instance::impl::write_format_chunk(format_chunk& chunk) {
+
+#ifdef TIME_FORMATTER_PERFORMANCE
+        cumulative_formatting_duration += chunk.formatting_duration;
+        formatting_counter += static_cast<u32>(chunk.messages.size());
+#endif
+
+        bool sync_needed = false;
+        {
+#ifdef TIME_WRITING_TO_FILE_PERFORMANCE
+            START_TIMER(writing_to_file)
+#endif
+            std::lock_guard<std::mutex> file_lock(general_mutex);
+            const char* message_begin = chunk.output.data();
+            for (size_t x = 0; x < chunk.messages.size(); x++) {
+
+                const u32 message_size = chunk.message_sizes[x];
+                if (message_size == 0)
+                    continue;
+
+                main_file.write(message_begin, message_size);
+                if (shared_buffer.is_open())
+                    shared_buffer.end_record();
+                if (index_block_size > 0)
+                    index_add_message(chunk.messages[x], message_size);
+                sync_needed |= chunk.messages[x].msg_sev >= severity::Error;
+                message_begin += message_size;
+            }
+            unsynced_data |= !chunk.output.empty();
+
+#ifdef TIME_WRITING_TO_FILE_PERFORMANCE
+            END_TIMER(writing_to_file)
+#endif
+        }
+
+        if (!socket_path.empty()) {                                 // outside of [general_mutex], the sink notes (dis)connects in the main file
+
+            std::lock_guard<std::mutex> socket_lock(socket_mutex);
+            const char* message_begin = chunk.output.data();
+            for (size_t x = 0; x < chunk.messages.size(); x++) {
+
+                if (chunk.message_sizes[x] == 0)
+                    continue;
+
+                socket_add_record(chunk.messages[x], std::string_view(message_begin, chunk.message_sizes[x]));
+                message_begin += chunk.message_sizes[x];
+            }
+        }
+
+#ifdef TIME_END_TO_END_PERFORMANCE
+        const auto now = std::chrono::system_clock::now();
+        for (size_t x = 0; x < chunk.messages.size(); x++) {
+
+            if (chunk.message_sizes[x] == 0)
+                continue;
+
+            const f32 end_to_end_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(now - chunk.messages[x].timestamp).count() / 1000.f;
+            cumulative_end_to_end_duration += end_to_end_duration;
+            max_end_to_end_duration = std::max(max_end_to_end_duration, end_to_end_duration);
+            end_to_end_counter++;
+        }
+#endif
+
+        if (durability_mode == durability::fsync_on_error && sync_needed)
+            sync_main_file(false);
+
+        if (write_logs_to_console && !chunk.output.empty()) {
+
+            START_COUT_TIMER
+            console.append(chunk.output, chunk.messages.size() - std::count(chunk.message_sizes.begin(), chunk.message_sizes.end(), 0u));
+            END_COUT_TIMER
+        }
+    }
+
+    // fill [format] with the content of [message]
+    // @param thread_lable Lable of the thread that logged the message, nullptr to use the thread id
+    // @param stack_trace_depth Max number of frames written by $U (init_options::stack_trace_depth)
+    void format_message(std::ostringstream& Format_Filled, const std::string& format, const message_format& message, const std::string* thread_lable, const u32 stack_trace_depth) {
+
+        char Format_Command;
+
+        const util::system_time loc_system_time = util::get_system_time(message.timestamp);
+
+        // Loop over Format string and build Final Message
+        int FormatLen = static_cast<int>(format.length());
+        for (int x = 0; x < FormatLen; x++) {
+
+            if (format[x] == '$' && x + 1 < FormatLen) {
+
+                Format_Command = format[x + 1];
+                switch (Format_Command) {
+
+                // ------------------------------------  Basic Info  -------------------------------------------------------------------------------
+                case 'B':   Format_Filled << console_color_table[(u8)message.msg_sev]; break;                                                                                               // Color Start
+                case 'E':   Format_Filled << console_reset; break;                                                                                                                          // Color End
+                case 'C':   Format_Filled << message.text(); break;                                                                                                                         // input text (message)
+                case 'L':   Format_Filled << severity_names[(u8)message.msg_sev]; break;                                                                                                    // Log Level
+                case 'X':   if (message.msg_sev == severity::Info || message.msg_sev == severity::Warn) { Format_Filled << " "; } break;                                                    // Alignment
+                case 'Z':   Format_Filled << "\n"; break;                                                                                                                                   // Alignment
+
+                // ------------------------------------  Source  -------------------------------------------------------------------------------
+                case 'R':   Format_Filled << current_process_id.load(std::memory_order_relaxed); break;                                                                                     // Process id
+                case 'Q':   if (thread_lable != nullptr) { Format_Filled << *thread_lable; } else { Format_Filled << message.thread_id; } break;                                         // Thread id or asosiated lable
+                case 'F':   Format_Filled << message.function_name; break;                                                                                                                  // Function Name
+                case 'P':   Format_Filled << SHORTEN_FUNC_NAME(message.function_name); break;                                                                                               // Function Name
+                case 'A':   Format_Filled << message.file_name; break;                                                                                                                      // File Name
+                case 'I':   Format_Filled << get_filename(message.file_name); break;                                                                                                        // Only File Name
+                case 'G':   Format_Filled << message.line; break;                                                                                                                           // Line
+                case 'V':   Format_Filled << message.sequence; break;                                                                                                                       // Sequence number
+                case 'W':   if (message.context) { write_context(Format_Filled, message.context.get()); } break;                                                                            // Context of the logging thread
+                case 'U':   if (message.stack_trace) { write_stack_trace(Format_Filled, *message.stack_trace, stack_trace_depth); } break;                                                                     // Stack trace
+
+                // ------------------------------------  Time  -------------------------------------------------------------------------------
+                case 'T':   Format_Filled << SETW(2) << (u16)loc_system_time.hour << ":" << SETW(2) << (u16)loc_system_time.minute << ":" << SETW(2) << (u16)loc_system_time.secund; break; // Clock hh:mm:ss
+                case 'H':   Format_Filled << SETW(2) << (u16)loc_system_time.hour; break;                                                                                                   // Clock secunde
+                case 'M':   Format_Filled << SETW(2) << (u16)loc_system_time.minute; break;                                                                                                 // Clock minute
+                case 'S':   Format_Filled << SETW(2) << (u16)loc_system_time.secund; break;                                                                                                 // Clock second
+                case 'J':   Format_Filled << SETW(3) << (u16)loc_system_time.millisecends; break;                                                                                           // Clock millisec.
+
+                // ------------------------------------  Date  -------------------------------------------------------------------------------
+                case 'N':   Format_Filled << SETW(4) << (u16)loc_system_time.year << "/" << SETW(2) << (u16)loc_system_time.month << "/" << SETW(2) << (u16)loc_system_time.day; break;     // Data yyyy/mm/dd
+                case 'Y':   Format_Filled << SETW(4) << (u16)loc_system_time.year; break;                                                                                                   // Year
+                case 'O':   Format_Filled << SETW(2) << (u16)loc_system_time.month; break;                                                                                                  // Month
+                case 'D':   Format_Filled << SETW(2) << (u16)loc_system_time.day; break;                                                                                                    // Day
+
+                // ------------------------------------  Default  -------------------------------------------------------------------------------
+                default: break;
+                }
+
+                x++;
+            }
+
+            else
+                Format_Filled << format[x];
+        }
+    }
+
+    // ====================================================================================================================================
+    // config file
+    // ====================================================================================================================================
+
+    static std::string trim(const std::string& text) {
+
+        const size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos)
+            return "";
+        const size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    static bool parse_severity(const std::string& text, severity& result) {
+
+        const char* names[] = { "trace", "debug", "info", "warn", "error", "fatal" };
+        for (u8 x = 0; x < 6; x++) {
+            if (strcasecmp(text.c_str(), names[x]) == 0) {
+                result = std::min(static_cast<severity>(x), severity::Error);           // Error & Fatal are always enabled
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool parse_on_off(const std::string& text, bool& result) {
+
+        if (text == "on" || text == "true" || text == "1")          { result = true; return true; }
+        if (text == "off" || text == "false" || text == "0")        { result = false; return true; }
+        return false;
+    }
+
+    // "<N>ms", fails for anything that doesn't fit into a u32 (never throws, a typo must not end the process)
+    static bool parse_milliseconds(const std::string& text, u32& result) {
+
+        if (text.size() <= 2 || !text.ends_with("ms"))
+            return false;
+
+        const char* end = text.data() + text.size() - 2;
+        const auto [parsed_end, error] = std::from_chars(text.data(), end, result);
+        return error == std::errc() && parsed_end == end;
+    }
+
+    // runs on the calling thread of init() or on [config_thread], never touches the active settings
+    bool instance::impl::load_config_file(runtime_config& config) {
+
+        std::ifstream file(config_file_path);
+        if (!file.is_open()) {
+
+            std::lock_guard<std::mutex> lock(general_mutex);
+            main_file << "[LOGGER] FAILED to open config file [" << config_file_path.string() << "]. Keeping current settings\n";
+            return false;
+        }
+
+        auto rules = std::make_shared<level_rules>();
+        std::string line;
+        u32 line_number = 0;
+        std::ostringstream errors;
+        while (std::getline(file, line)) {
+
+            line_number++;
+            const std::string content = trim(line);
+            if (content.empty() || content[0] == '#')
+                continue;
+
+            const size_t equal_sign = content.find('=');
+            if (equal_sign == std::string::npos) {
+                errors << " line " << line_number << ": missing '='";
+                continue;
+            }
+
+            const std::string key = trim(content.substr(0, equal_sign));
+            std::string value = trim(content.substr(equal_sign + 1));
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+                value = value.substr(1, value.size() - 2);
+
+            bool valid = true;
+            severity level = severity::Trace;
+            if (key == "format")
+                config.format = value;
+            else if (key == "console") {
+                bool log_to_console = false;
+                if ((valid = parse_on_off(value, log_to_console)))
+                    config.log_to_console = log_to_console;
+            }
+            else if (key == "flush") {
+                if (value == "none" || value == "batch")
+                    config.flush_each_batch = (value == "batch");
+                else
+                    valid = false;
+            }
+            else if (key == "durability") {
+                if (value == "none")                config.durability_mode = durability::none;
+                else if (value == "batch")          config.durability_mode = durability::fdatasync_per_batch;
+                else if (value == "error")          config.durability_mode = durability::fsync_on_error;
+                else if (u32 interval_ms = 0; parse_milliseconds(value, interval_ms)) {
+                    config.durability_mode = durability::fsync_interval;
+                    config.fsync_interval_ms = interval_ms;
+                }
+                else
+                    valid = false;
+            }
+            else if (key == "level" && (valid = parse_severity(value, level)))
+                rules->default_level = level;
+            else if (key.rfind("level.file.", 0) == 0 && (valid = parse_severity(value, level)))
+                rules->file_levels[key.substr(11)] = level;
+            else if (key.rfind("level.thread.", 0) == 0 && (valid = parse_severity(value, level)))
+                rules->thread_levels[key.substr(13)] = level;
+            else if (key != "level" && key.rfind("level.", 0) != 0)
+                valid = false;
+
+            if (!valid)
+                errors << " line " << line_number << ": invalid [" << key << " = " << value << "]";
+        }
+
+        if (!errors.str().empty()) {
+
+            std::lock_guard<std::mutex> lock(general_mutex);
+            main_file << "[LOGGER] Ignored entries in config file [" << config_file_path.string() << "]:" << errors.str() << "\n";
+        }
+
+        rules->lowest = rules->default_level;
+        for (const auto& [name, level] : rules->file_levels)
+            rules->lowest = std::min(rules->lowest, level);
+        for (const auto& [name, level] : rules->thread_levels)
+            rules->lowest = std::min(rules->lowest, level);
+
+        config.levels = std::move(rules);
+        return true;
+    }
+
+    // [config_thread]: waits for changes of the config file and hands the parsed content to the worker.
+    // The directory is watched, because most editors replace the file instead of writing into it
+    void instance::impl::watch_config_file() {
+
+#ifdef __linux__
+        const int inotify_fd = inotify_init1(IN_CLOEXEC);
+        const std::filesystem::path directory = config_file_path.has_parent_path() ? config_file_path.parent_path() : ".";
+        if (inotify_fd < 0 || inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+
+            std::lock_guard<std::mutex> lock(general_mutex);
+            main_file << "[LOGGER] FAILED to watch config file [" << config_file_path.string() << "]. Changes will not be applied\n";
+            if (inotify_fd >= 0)
+                close(inotify_fd);
+            return;
+        }
+
+        const std::string file_name = config_file_path.filename().string();
+        alignas(inotify_event) char buffer[4096];
+        pollfd poll_fds[2] = { { inotify_fd, POLLIN, 0 }, { config_wakeup_fd, POLLIN, 0 } };
+        while (!stop) {
+
+            const int ready = poll(poll_fds, 2, -1);
+            if (ready < 0 && errno == EINTR)
+                continue;                                           // interrupted by a signal of the host
+            if (ready < 0 || (poll_fds[1].revents & POLLIN))
+                break;
+
+            const ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+            bool changed = false;
+            for (ssize_t offset = 0; offset < length; ) {
+
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                if (event->len > 0 && file_name == event->name)
+                    changed = true;
+                offset += sizeof(inotify_event) + event->len;
+            }
+
+            if (!changed)
+                continue;
+
+            auto config = std::make_unique<runtime_config>();
+            if (!load_config_file(*config))
+                continue;
+
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                pending_config = std::move(config);
+                config_pending = true;
+                work_counter.fetch_add(1, std::memory_order_release);
+            }
+            cv->notify_all();
+        }
+
+        close(inotify_fd);
+#endif
+    }
+
+    // called by the worker between two batches (or by init() bevor the worker starts)
+    void instance::impl::apply_config(runtime_config&& config) {
+
+        std::lock_guard<std::mutex> lock(general_mutex);
+        main_file << "[LOGGER] Applying config file [" << config_file_path.string() << "]\n";
+
+        if (config.format && *config.format != format_current) {
+
+            format_prev = format_current;
+            format_current = *config.format;
+            main_file << "[LOGGER] Changing log-format. From [" << format_prev << "] to [" << format_current << "]\n";
+        }
+
+        if (config.log_to_console)
+            write_logs_to_console = *config.log_to_console;
+
+        if (config.flush_each_batch)
+            flush_each_batch = *config.flush_each_batch;
+
+        if (config.durability_mode)
+            durability_mode = *config.durability_mode;
+
+        if (config.fsync_interval_ms) {
+            fsync_interval = std::chrono::milliseconds(*config.fsync_interval_ms);
+            next_sync = std::chrono::steady_clock::now() + fsync_interval;
+        }
+
+        if (config.levels) {
+
+            levels = std::move(config.levels);
+            lowest_level.store(static_cast<u8>(levels->lowest), std::memory_order_relaxed);
+        }
+
+        config_version++;
+    }
+
+    // ====================================================================================================================================
+    // fork
+    // ====================================================================================================================================
+
+    void instance::impl::fork_prepare() {
+
+        live_instances_mutex.lock();
+        for (impl* instance : live_instances)
+            instance->prepare_fork();
+    }
+
+    void instance::impl::fork_parent() {
+
+        for (impl* instance : live_instances)
+            instance->after_fork(false);
+        live_instances_mutex.unlock();
+    }
+
+    void instance::impl::fork_child() {
+
+#ifdef __unix__
+        current_process_id = getpid();
+#endif
+        for (impl* instance : live_instances)
+            instance->after_fork(true);
+        live_instances_mutex.unlock();
+    }
+
+    // hold all locks over the fork so the child gets a consistent copy, the buffers are flushed so the child doesn't write them again.
+    // The worker and the formatter threads work outside of the locks, so the worker is paused at a safe point first (pause_for_fork())
+    void instance::impl::prepare_fork() {
+
+        std::unique_lock<std::mutex> queue_lock(queue_mutex);
+        if (worker_running) {
+
+            fork_pending = true;
+            work_counter.fetch_add(1, std::memory_order_release);          // wakes a spinning worker
+            cv->notify_all();
+            fork_cv->wait(queue_lock, [this] { return worker_paused || !worker_running; });
+        }
+        queue_lock.release();                                               // [queue_mutex] stays locked until after_fork()
+        socket_mutex.lock();
+        general_mutex.lock();
+        formatter_mutex.lock();
+        backtrace_mutex.lock();
+        profiler.mutex().lock();
+        console.prepare_fork();
+
+        main_file.flush();
+        for (auto& [thread_id, file] : thread_files) {
+
+            std::lock_guard<std::mutex> file_lock(file->mutex);
+            file->file.flush();
+        }
+    }
+
+    // The child only has the forking thread. Everything queued bevor the fork is written by the parent,
+    // so the child starts with empty queues and its own worker, formatter and config threads
+    void instance::impl::after_fork(const bool in_child) {
+
+        if (in_child) {
+
+            // the thread objects refer to threads of the parent and the condition variables can have waiters of the parent,
+            // destroying them would terminate or block. They are leaked on purpose and replaced by new ones
+            const size_t formatter_count = formatter_pool.size();
+            (void)worker_thread.release();
+            for (std::unique_ptr<std::thread>& formatter : formatter_pool)
+                (void)formatter.release();
+            formatter_pool.clear();
+            const bool watch_config = static_cast<bool>(config_thread);
+            (void)config_thread.release();
+
+            (void)cv.release();
+            (void)formatter_cv.release();
+            (void)formatter_done_cv.release();
+            (void)fork_cv.release();
+            cv = std::make_unique<std::condition_variable>();
+            formatter_cv = std::make_unique<std::condition_variable>();
+            formatter_done_cv = std::make_unique<std::condition_variable>();
+            fork_cv = std::make_unique<std::condition_variable>();
+
+            log_queue.clear();
+            control_queue = {};
+            next_sequence = 0;
+            worker_parked = false;
+            worker_running = false;
+            fork_pending = false;
+            worker_paused = false;
+            pending_config.reset();
+            config_pending = false;
+            formatter_jobs.clear();
+            formatter_stop = false;
+            chunks_in_flight.clear();
+
+            // the connection belongs to the parent, the child connects on its own
+            if (socket_fd >= 0) {
+#ifdef __unix__
+                close(socket_fd);
+#endif
+                socket_fd = -1;
+            }
+            socket_pending.clear();
+            socket_pending_bytes = 0;
+            socket_sent_offset = 0;
+            socket_batch.clear();
+            socket_batch_records = 0;
+            next_socket_attempt = {};
+
+            open_process_main_file();
+
+            console.after_fork(true);
+            profiler.mutex().unlock();
+            backtrace_mutex.unlock();
+            formatter_mutex.unlock();
+            general_mutex.unlock();
+            socket_mutex.unlock();
+            queue_mutex.unlock();
+
+            for (size_t x = 0; x < formatter_count; x++)
+                formatter_pool.push_back(std::make_unique<std::thread>(&impl::run_formatter, this));
+            worker_thread = std::make_unique<std::thread>(&impl::process_queue, this);
+
+#ifdef __linux__
+            if (watch_config) {
+
+                close(config_wakeup_fd);
+                config_wakeup_fd = eventfd(0, EFD_CLOEXEC);
+                config_thread = std::make_unique<std::thread>(&impl::watch_config_file, this);
+            }
+#endif
+            (void)watch_config;
+            return;
+        }
+
+        fork_pending = false;
+        fork_cv->notify_all();
+        console.after_fork(false);
+        profiler.mutex().unlock();
+        backtrace_mutex.unlock();
+        formatter_mutex.unlock();
+        general_mutex.unlock();
+        socket_mutex.unlock();
+        queue_mutex.unlock();
+    }
+
+    // [fork_pending]: called by the worker at a safe point while holding [queue_mutex]. The chunks in flight are written first so the
+    // formatter threads are idle, then the worker waits until after_fork(). prepare_fork() gets [queue_mutex] while the worker waits
+    void instance::impl::pause_for_fork(std::unique_lock<std::mutex>& lock) {
+
+        lock.unlock();
+        write_format_chunks(0);
+        lock.lock();
+
+        worker_paused = true;
+        fork_cv->notify_all();
+        fork_cv->wait(lock, [this] { return !fork_pending; });
+        worker_paused = false;
+    }
+
+    // child after fork(): a compressed main file has one compressor state and an indexed one a single set of offsets, both can't be
+    // continued by two processes. The child drops its copies without writing them and continues in its own file <name>.<pid>.<extension>
+    // (with its own index). Plain main files are kept, both processes write into them
+    void instance::impl::open_process_main_file() {
+
+        const bool compressed = compressor.is_open();
+        const bool indexed = index_block_size > 0;
+        if (!compressed && !indexed)
+            return;
+
+        // [main_file] & [index_file] were flushed in prepare_fork(), closing the copies doesn't write anything
+        if (compressed)
+            compressor.abandon();
+        if (indexed)
+            index_file.close();
+        CLOSE_MAIN_FILE()
+#ifdef __unix__
+        if (main_file_sync_fd >= 0) {
+            close(main_file_sync_fd);
+            main_file_sync_fd = -1;
+        }
+#endif
+
+        const std::filesystem::path parent_file_path = main_log_file_path;
+        std::string file_name = main_log_file_path.filename().string();
+        const size_t extension = file_name.find('.');
+        file_name.insert((extension == std::string::npos) ? file_name.size() : extension, "." + std::to_string(current_process_id.load()));
+        main_log_file_path.replace_filename(file_name);
+
+        main_file = std::ofstream(main_log_file_path, std::ios::binary | std::ios::out);
+        if (compressed) {
+
+            if (main_file.is_open() && compressor.open(compressor.mode(), main_file.rdbuf(), compressor.level()))
+                static_cast<std::ostream&>(main_file).rdbuf(&compressor);
+            else
+                CLOSE_MAIN_FILE()                               // log nothing rather than plain text into a compressed file
+        }
+        if (indexed && (!main_file.is_open() || !open_index_file(false)))
+            index_block_size = 0;
+
+        main_file << "[LOGGER] Process [" << current_process_id.load() << "] forked from the process logging into [" << parent_file_path.string() << "]\n";
+    }
+
+    // ====================================================================================================================================
+    // socket sink
+    // ====================================================================================================================================
+
+    // append a record to the frame of the current batch, large batches are split into multiple frames
+    void instance::impl::socket_add_record(const message_format& message, const std::string_view formatted_message) {
+
+        if (socket_batch.empty())
+            socket_batch.resize(sizeof(socket_batch_header));
+
+        const size_t record_begin = socket_batch.size();
+        socket_batch.resize(record_begin + sizeof(u32));
+        if (socket_record == socket_record_type::formatted)
+            socket_batch += formatted_message;
+        else {
+
+            const std::string_view file_name = message.file_name;
+            const std::string_view function_name = message.function_name;
+            socket_binary_record record{};
+            record.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(message.timestamp.time_since_epoch()).count();
+            record.thread_id = std::hash<std::thread::id>{}(message.thread_id);
+            record.sequence = message.sequence;
+            record.line = static_cast<u32>(message.line);
+            record.message_size = static_cast<u32>(message.text().size());
+            record.file_name_size = static_cast<u16>(std::min<size_t>(file_name.size(), UINT16_MAX));
+            record.function_name_size = static_cast<u16>(std::min<size_t>(function_name.size(), UINT16_MAX));
+            record.severity = static_cast<u8>(message.msg_sev);
+
+            socket_batch.append(reinterpret_cast<const char*>(&record), sizeof(record));
+            socket_batch.append(file_name.substr(0, record.file_name_size));
+            socket_batch.append(function_name.substr(0, record.function_name_size));
+            socket_batch += message.text();
+        }
+
+        const u32 record_size = static_cast<u32>(socket_batch.size() - record_begin - sizeof(u32));
+        std::memcpy(socket_batch.data() + record_begin, &record_size, sizeof(u32));
+        socket_batch_records++;
+
+        if (socket_batch.size() >= 64 * 1024)
+            socket_end_batch();
+    }
+
+    // close the frame of the current batch and try to send everything pending
+    void instance::impl::socket_end_batch() {
+
+        if (socket_batch_records > 0) {
+
+            socket_batch_header header{};
+            header.magic = socket_batch_magic;
+            header.payload_size = static_cast<u32>(socket_batch.size() - sizeof(header));
+            header.record_count = socket_batch_records;
+            header.record_type = static_cast<u8>(socket_record);
+            std::memcpy(socket_batch.data(), &header, sizeof(header));
+
+            socket_pending_bytes += socket_batch.size();
+            socket_pending.push_back(std::move(socket_batch));
+            socket_batch.clear();
+            socket_batch_records = 0;
+
+            // bounded buffer: drop the oldest frames, but never the one that is partially sent
+            while (socket_pending_bytes > socket_buffer_size && socket_pending.size() > 1) {
+
+                const auto dropped = socket_pending.begin() + ((socket_sent_offset > 0) ? 1 : 0);
+                socket_batch_header dropped_header{};
+                std::memcpy(&dropped_header, dropped->data(), sizeof(dropped_header));
+                socket_dropped_records += dropped_header.record_count;
+                socket_pending_bytes -= dropped->size();
+                socket_pending.erase(dropped);
+            }
+        }
+
+        socket_send_pending();
+    }
+
+    // send as much as possible without blocking, reconnects at most every [socket_reconnect_interval]
+    void instance::impl::socket_send_pending() {
+
+#ifdef __unix__
+        if (socket_pending.empty())
+            return;
+
+        if (socket_fd < 0) {
+
+            if (std::chrono::steady_clock::now() < next_socket_attempt)
+                return;
+
+            if (!socket_connect()) {
+                next_socket_attempt = std::chrono::steady_clock::now() + socket_reconnect_interval;
+                return;
+            }
+        }
+
+        while (!socket_pending.empty()) {
+
+            const std::string& frame = socket_pending.front();
+            const ssize_t sent = send(socket_fd, frame.data() + socket_sent_offset, frame.size() - socket_sent_offset, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (sent < 0) {
+
+                if (errno == EINTR)
+                    continue;
+
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {                  // collector is slow, retry soon
+                    next_socket_attempt = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+                    return;
+                }
+
+                socket_disconnect(std::strerror(errno));
+                next_socket_attempt = std::chrono::steady_clock::now() + socket_reconnect_interval;
+                return;
+            }
+
+            socket_sent_offset += static_cast<size_t>(sent);
+            if (socket_sent_offset < frame.size())
+                continue;
+
+            socket_batch_header header{};
+            std::memcpy(&header, frame.data(), sizeof(header));
+            socket_sent_records += header.record_count;
+            socket_pending_bytes -= frame.size();
+            socket_sent_offset = 0;
+            socket_pending.pop_front();
+        }
+#endif
+    }
+
+    bool instance::impl::socket_connect() {
+
+#ifdef __unix__
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path))
+            return false;
+        std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+        const int new_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (new_socket < 0)
+            return false;
+
+        if (connect(new_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            close(new_socket);
+            return false;
+        }
+
+        socket_fd = new_socket;
+        std::lock_guard<std::mutex> lock(general_mutex);
+        main_file << "[LOGGER] Connected to socket sink [" << socket_path << "]";
+        if (socket_dropped_records > socket_dropped_reported)
+            main_file << ", dropped [" << socket_dropped_records - socket_dropped_reported << "] records while disconnected";
+        main_file << "\n";
+        socket_dropped_reported = socket_dropped_records;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // the partially sent frame is sent again from the beginning after reconnecting (the collector discards incomplete frames)
+    void instance::impl::socket_disconnect(const char* reason) {
+
+#ifdef __unix__
+        close(socket_fd);
+#endif
+        socket_fd = -1;
+        socket_sent_offset = 0;
+
+        std::lock_guard<std::mutex> lock(general_mutex);
+        main_file << "[LOGGER] Lost connection to socket sink [" << socket_path << "] (" << reason << "), buffering up to [" << socket_buffer_size / 1024 << " KB]\n";
+    }
+
+    // called by shutdown() after the worker stopped, waits at most 200ms for a slow collector
+    void instance::impl::socket_shutdown() {
+
+        std::lock_guard<std::mutex> socket_lock(socket_mutex);
+#ifdef __unix__
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+        next_socket_attempt = {};                                           // one last connection attempt
+        socket_send_pending();
+        while (socket_fd >= 0 && !socket_pending.empty() && std::chrono::steady_clock::now() < deadline) {
+
+            pollfd poll_fd{ socket_fd, POLLOUT, 0 };
+            poll(&poll_fd, 1, 10);
+            socket_send_pending();
+        }
+
+        if (socket_fd >= 0) {
+            close(socket_fd);
+            socket_fd = -1;
+        }
 #endif
+        for (const std::string& frame : socket_pending) {
+
+            socket_batch_header header{};
+            std::memcpy(&header, frame.data(), sizeof(header));
+            socket_dropped_records += header.record_count;
+        }
+        socket_pending.clear();
+        socket_pending_bytes = 0;
+        socket_sent_offset = 0;
+        socket_batch.clear();
+        socket_batch_records = 0;
+    }
+
+    // ====================================================================================================================================
+    // per thread files
+    // ====================================================================================================================================
+
+    // called while holding [general_mutex]
+    void instance::impl::open_thread_file(const std::string& thread_lable, std::thread::id thread_id) {
+
+        std::string file_name = "thread_";
+        for (const char c : thread_lable)
+            file_name += (std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_') ? c : '_';
+
+        // two threads with the same lable get diffrent files
+        std::string unique_file_name = file_name;
+        for (u32 x = 2; std::any_of(thread_files.begin(), thread_files.end(), [&](const auto& entry) { return entry.first != thread_id && entry.second->file_name == unique_file_name; }); x++)
+            unique_file_name = file_name + "_" + std::to_string(x);
+
+        auto file = std::make_shared<thread_file>();
+        file->lable = thread_lable;
+        file->file_name = unique_file_name;
+        file->format = format_current;
+        file->levels = levels;
+        file->config_version = config_version;
+        const bool append = use_append_mode || !thread_file_names.insert(unique_file_name).second;        // dont truncate a file that was already used in this session
+        file->file = std::ofstream(main_log_dir / (unique_file_name + ".log"), (append) ? std::ios::app : std::ios::out);
+        if (!file->file.is_open()) {
+
+            main_file << "[LOGGER] FAILED to open thread file for lable: [" << thread_lable << "]. Messages of this thread go into the main file\n";
+            return;
+        }
+
+        main_file << "[LOGGER] Thread-ID: [" << thread_id << "] writes into file: [" << (main_log_dir / (unique_file_name + ".log")).string() << "]\n";
+        thread_files[thread_id] = std::move(file);
+        thread_files_generation++;
+    }
+
+    // only takes [general_mutex] if the calling thread has no valid cache entry (first message, lable changed or multiple instances used alternately)
+    std::shared_ptr<thread_file> instance::impl::get_thread_file() {
+
+        if (local_thread_file.instance_id == instance_id && local_thread_file.generation == thread_files_generation.load(std::memory_order_acquire))
+            return local_thread_file.file;
+
+        std::lock_guard<std::mutex> lock(general_mutex);
+        const auto file = thread_files.find(std::this_thread::get_id());
+        local_thread_file.instance_id = instance_id;
+        local_thread_file.generation = thread_files_generation.load(std::memory_order_relaxed);
+        local_thread_file.file = (file != thread_files.end()) ? file->second : nullptr;
+        return local_thread_file.file;
+    }
+
+    // Every record is prefixed with "@<microseconds since epoch>:<length of formatted message> " so [log_merge] can order records from diffrent files
+    void instance::impl::write_thread_file(thread_file& file, const message_format& message) {
+
+        if (file.config_version != config_version.load(std::memory_order_acquire)) {
+
+            std::lock_guard<std::mutex> lock(general_mutex);
+            file.format = format_current;
+            file.levels = levels;
+            file.config_version = config_version.load(std::memory_order_relaxed);
+        }
+
+        if (!file.levels->enabled(message, &file.lable))
+            return;
+
+        const int64 timestamp = std::chrono::duration_cast<std::chrono::microseconds>(message.timestamp.time_since_epoch()).count();
+        std::ostringstream Format_Filled;
+        const auto formatting_start = (profile_call_sites) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+        format_message(Format_Filled, file.format, message, &file.lable, stack_trace_depth);
+        const std::string formatted_message = Format_Filled.str();
+        if (profile_call_sites)
+            profiler.record(message, formatted_message.size(), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - formatting_start).count());
+
+        {
+            std::lock_guard<std::mutex> file_lock(file.mutex);
+            if (file.closed)
+                return;
+
+            file.file << '@' << timestamp << ':' << formatted_message.size() << ' ' << formatted_message;
         }
 
         if (write_logs_to_console) {
 
-            START_COUT_TIMER
-            std::cout << Format_Filled.str();
-            END_COUT_TIMER
+            console.append(formatted_message);
+            console.wake();                                         // not written by the worker, there is no batch end
+        }
+    }
+
+    // ====================================================================================================================================
+    // instance
+    // ====================================================================================================================================
+
+    instance::instance()
+        : m_impl(std::make_unique<impl>()) { }
+
+    instance::instance(const std::string& format, const bool log_to_console, const std::filesystem::path log_dir, const std::string& main_log_file_name, const bool use_append_mode, const init_options& options)
+        : instance() { init(format, log_to_console, log_dir, main_log_file_name, use_append_mode, options); }
+
+    instance::~instance() {
+
+        if (m_impl->is_init)
+            m_impl->shutdown();
+    }
+
+    bool instance::init(const std::string& format, const bool log_to_console, const std::filesystem::path log_dir, const std::string& main_log_file_name, const bool use_append_mode, const init_options& options) {
+        return m_impl->init(format, log_to_console, log_dir, main_log_file_name, use_append_mode, options);
+    }
+
+    void instance::shutdown()                                                                                   { m_impl->shutdown(); }
+
+    bool instance::is_initialized() const                                                                       { return m_impl->is_init; }
+
+    void instance::set_format(const std::string& new_format)                                                    { m_impl->set_format(new_format); }
+
+    void instance::use_previous_format()                                                                        { m_impl->use_previous_format(); }
+
+    const std::string instance::get_format() {
+
+        std::lock_guard<std::mutex> lock(m_impl->general_mutex);
+        return m_impl->format_current;
+    }
+
+    void instance::flush()                                                                                      { m_impl->flush_async().wait(); }
+
+    std::future<void> instance::flush_async()                                                                   { return m_impl->flush_async(); }
+
+    void instance::dump_backtrace()                                                                             { m_impl->dump_backtrace(); }
+
+    std::vector<call_site_stats> instance::get_call_site_stats(const u32 max_count)                             { return m_impl->profiler.collect(max_count); }
+
+    stats instance::get_stats() {
+
+        stats result{};
+        const impl& data = *m_impl;
+#ifdef TIME_FORMATTER_PERFORMANCE
+        result.formatting_counter = data.formatting_counter;
+        result.average_formatting_time = (data.formatting_counter > 0) ? data.cumulative_formatting_duration / data.formatting_counter : 0;
+#endif
+#ifdef TIME_QUEUE_ADDING_PERFORMANCE
+        result.queue_adding_counter = data.queue_adding_counter;
+        result.average_queue_adding_time = (data.queue_adding_counter > 0) ? data.cumulative_queue_adding_duration / data.queue_adding_counter : 0;
+#endif
+#ifdef TIME_WRITING_TO_FILE_PERFORMANCE
+        result.writing_to_file_counter = data.writing_to_file_counter;
+        result.average_writing_to_file_time = (data.writing_to_file_counter > 0) ? data.cumulative_writing_to_file_duration / data.writing_to_file_counter : 0;
+#endif
+#ifdef TIME_COUT_PERFORMANCE
+        result.cout_counter = data.cout_counter;
+        result.average_cout_time = (data.cout_counter > 0) ? data.cumulative_cout_duration / data.cout_counter : 0;
+#endif
+#ifdef TIME_END_TO_END_PERFORMANCE
+        result.end_to_end_counter = data.end_to_end_counter;
+        result.average_end_to_end_latency = (data.end_to_end_counter > 0) ? data.cumulative_end_to_end_duration / data.end_to_end_counter : 0;
+        result.max_end_to_end_latency = data.max_end_to_end_duration;
+#endif
+        result.compression_input_bytes = data.compressor.input_bytes;
+        result.compression_output_bytes = data.compressor.output_bytes;
+        result.compression_ratio = (data.compressor.output_bytes > 0) ? static_cast<f32>(data.compressor.input_bytes) / data.compressor.output_bytes : 0;
+        result.compression_counter = data.compressor.compress_counter;
+        result.average_compression_time = (data.compressor.compress_counter > 0) ? data.compressor.cumulative_compress_duration / data.compressor.compress_counter : 0;
+        result.socket_sent_records = data.socket_sent_records;
+        result.socket_dropped_records = data.socket_dropped_records;
+        result.console_dropped_messages = data.console.dropped_messages();
+        return result;
+    }
+
+    void instance::register_label_for_thread(const std::string& thread_lable, std::thread::id thread_id)         { m_impl->register_label_for_thread(thread_lable, thread_id); }
+
+    void instance::unregister_label_for_thread(std::thread::id thread_id)                                       { m_impl->unregister_label_for_thread(thread_id); }
+
+    void instance::log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, std::string message) {
+        m_impl->log_msg(msg_sev, file_name, function_name, line, thread_id, std::move(message));
+    }
+
+    void instance::log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const static_text message) {
+        m_impl->log_msg(msg_sev, file_name, function_name, line, thread_id, message);
+    }
+
+    // ====================================================================================================================================
+    // default instance (used by the free functions and the LOG() macros)
+    // ====================================================================================================================================
+
+    instance& default_instance() {
+
+        static instance default_logger{};
+        return default_logger;
+    }
+
+    bool init(const std::string& format, const bool log_to_console, const std::filesystem::path log_dir, const std::string& main_log_file_name, const bool use_append_mode, const init_options& options) {
+        return default_instance().init(format, log_to_console, log_dir, main_log_file_name, use_append_mode, options);
+    }
+
+    void shutdown()                                                                                             { default_instance().shutdown(); }
+
+    void set_format(const std::string& new_format)                                                              { default_instance().set_format(new_format); }
+
+    void use_previous_format()                                                                                  { default_instance().use_previous_format(); }
+
+    const std::string get_format()                                                                              { return default_instance().get_format(); }
+
+    void flush()                                                                                                { default_instance().flush(); }
+
+    std::future<void> flush_async()                                                                             { return default_instance().flush_async(); }
+
+    void dump_backtrace()                                                                                       { default_instance().dump_backtrace(); }
+
+    std::vector<call_site_stats> get_call_site_stats(const u32 max_count)                                       { return default_instance().get_call_site_stats(max_count); }
+
+    stats get_stats()                                                                                           { return default_instance().get_stats(); }
+
+    void register_label_for_thread(const std::string& thread_lable, std::thread::id thread_id)                  { default_instance().register_label_for_thread(thread_lable, thread_id); }
+
+    void unregister_label_for_thread(std::thread::id thread_id)                                                 { default_instance().unregister_label_for_thread(thread_id); }
+
+    void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, std::string message) {
+        default_instance().log_msg(msg_sev, file_name, function_name, line, thread_id, std::move(message));
+    }
+
+    void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const static_text message) {
+        default_instance().log_msg(msg_sev, file_name, function_name, line, thread_id, message);
+    }
+
+    // ====================================================================================================================================
+    // check pass counters (ASSERT / VALIDATE call sites, see ENABLE_CHECK_PASS_COUNTERS)
+    // ====================================================================================================================================
+
+    static std::atomic<check_site*>         check_sites_head = nullptr;
+
+    // called once per call site (function local static), the list is only ever extended
+    check_site::check_site(const char* file_name, const int line, const char* expression)
+        : file_name(file_name), line(line), expression(expression) {
+
+        next = check_sites_head.load(std::memory_order_relaxed);
+        while (!check_sites_head.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) { }
+    }
+
+    std::vector<check_site_stats> get_check_stats() {
+
+        std::vector<check_site_stats> result;
+        for (const check_site* site = check_sites_head.load(std::memory_order_acquire); site != nullptr; site = site->next)
+            result.push_back({ site->file_name, site->line, site->expression, site->passes.load(std::memory_order_relaxed) });
+
+        std::sort(result.begin(), result.end(), [](const check_site_stats& a, const check_site_stats& b) { return a.passes > b.passes; });
+        return result;
+    }
+
+    // ====================================================================================================================================
+    // sidecar index
+    // ====================================================================================================================================
+
+    // open [index_file] next to [main_log_file_path], from here on [index_counter] counts the output of [main_file]
+    // @param append Continue an existing index of the same version
+    // @return false if the index file can't be opened
+    bool instance::impl::open_index_file(const bool append) {
+
+        std::filesystem::path index_file_path = main_log_file_path;
+        index_file_path += ".idx";
+        index_file = std::ofstream(index_file_path, std::ios::binary | ((append) ? std::ios::app : std::ios::out));
+        bool index_exists = false;
+        if (index_file.is_open() && append) {
+
+            index_file.seekp(0, std::ios::end);
+            if (index_file.tellp() >= static_cast<std::streamoff>(sizeof(index_header))) {
+
+                index_header header{};
+                std::ifstream existing_index(index_file_path, std::ios::binary);
+                index_exists = existing_index.read(reinterpret_cast<char*>(&header), sizeof(header)) && std::memcmp(header.magic, index_magic, sizeof(header.magic)) == 0;
+            }
+            if (!index_exists)                                  // empty, broken or an older version, start a new one
+                index_file = std::ofstream(index_file_path, std::ios::binary | std::ios::out);
+        }
+        if (!index_file.is_open())
+            return false;
+
+        if (!index_exists) {
+
+            index_header header{};
+            std::memcpy(header.magic, index_magic, sizeof(header.magic));
+            header.block_size = index_block_size;
+            index_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+
+        index_counter.open(main_file.rdbuf(), static_cast<u64>(main_file.tellp()));
+        static_cast<std::ostream&>(main_file).rdbuf(&index_counter);
+        index_block = {};
+        index_block.begin_offset = index_counter.position();
+        index_block_bytes = 0;
+        index_block_records.clear();
+        index_block_timestamps.clear();
+        index_pending.clear();
+        index_pending_records.clear();
+        return true;
+    }
+
+    // called by the worker, and by write_message_now() on the calling thread for synchronous_errors, always while holding [general_mutex],
+    // after the message was written to [main_file]
+    void instance::impl::index_add_message(const message_format& message, const size_t message_size) {
+
+        const u64 message_offset = index_counter.position() - message_size;
+        const int64 timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(message.timestamp.time_since_epoch()).count();
+        if (index_block.severity_mask != 0 && std::max(index_block.max_timestamp, timestamp) - std::min(index_block.min_timestamp, timestamp) > static_cast<int64>(UINT32_MAX))
+            index_close_block(message_offset);                      // [index_record::time_offset] is 32-bit (~49 days per block)
+
+        if (index_block.severity_mask == 0) {
+            index_block.min_timestamp = timestamp;
+            index_block.max_timestamp = timestamp;
+        }
+        index_block.min_timestamp = std::min(index_block.min_timestamp, timestamp);
+        index_block.max_timestamp = std::max(index_block.max_timestamp, timestamp);
+        index_block.severity_mask |= static_cast<u8>(BIT(message.msg_sev));
+
+        u64 thread_bit = 0;
+        const auto lable = thread_lable_map.find(message.thread_id);
+        if (lable != thread_lable_map.end())
+            thread_bit = index_thread_bit(lable->second);
+        else {
+
+            auto cached_bit = index_thread_id_bits.find(message.thread_id);
+            if (cached_bit == index_thread_id_bits.end()) {
+
+                std::ostringstream thread_id_string;
+                thread_id_string << message.thread_id;
+                cached_bit = index_thread_id_bits.emplace(message.thread_id, index_thread_bit(thread_id_string.str())).first;
+            }
+            thread_bit = cached_bit->second;
         }
+        index_block.thread_mask |= thread_bit;
+
+        index_record record{};
+        record.offset = static_cast<u32>(message_offset - index_block.begin_offset);
+        record.size = static_cast<u32>(message_size);
+        record.thread_bit = static_cast<u8>(std::countr_zero(thread_bit));
+        record.severity = static_cast<u8>(message.msg_sev);
+        index_block_records.push_back(record);
+        index_block_timestamps.push_back(timestamp);
+
+        index_block_bytes += message_size;
+        if (index_block_bytes >= index_block_size)
+            index_close_block(index_counter.position());
+    }
+
+    // [main_file] offsets come from [index_counter], other log output (e.g. thread lables) bypasses the message counter
+    // @param end_offset Offset in [main_file] after the last message of the block
+    void instance::impl::index_close_block(const u64 end_offset) {
+
+        if (index_block.severity_mask == 0)
+            return;                     // nothing logged into this block
+
+        index_block.end_offset = end_offset;
+        index_block.record_count = static_cast<u32>(index_block_records.size());
+        for (size_t x = 0; x < index_block_records.size(); x++)
+            index_block_records[x].time_offset = static_cast<u32>(index_block_timestamps[x] - index_block.min_timestamp);
+        index_pending.push_back(index_block);
+        index_pending_records.insert(index_pending_records.end(), index_block_records.begin(), index_block_records.end());
+
+        index_block = {};
+        index_block.begin_offset = end_offset;
+        index_block_bytes = 0;
+        index_block_records.clear();
+        index_block_timestamps.clear();
+    }
+
+    // blocks can also be closed by synchronous_errors on other threads. [index_file] is written while holding [general_mutex],
+    // so a fork() (prepare_fork() holds it) never copies a half written index buffer into the child
+    void instance::impl::index_write_pending() {
 
+        // log data has to reach the file bevor the index points to it
+        std::lock_guard<std::mutex> file_lock(general_mutex);
+        if (index_pending.empty())
+            return;
+
+        main_file.flush();
+        const index_record* records = index_pending_records.data();
+        for (const index_entry& entry : index_pending) {
+
+            index_file.write(reinterpret_cast<const char*>(&entry), sizeof(index_entry));
+            index_file.write(reinterpret_cast<const char*>(records), entry.record_count * sizeof(index_record));
+            records += entry.record_count;
+        }
+        index_file.flush();
+        index_pending.clear();
+        index_pending_records.clear();
     }
 }
 
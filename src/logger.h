@@ -1,10 +1,15 @@
 
 #include <string>
+#include <memory>
+#include <future>
 #include <filesystem>
 #include <exception>
 #include <thread>
 #include <format>
 #include <string_view>
+#include <sstream>
+#include <atomic>
+#include <vector>
 
 #include "util.h"
 
@@ -37,33 +42,332 @@ namespace logger {
         Fatal,
     };
 
+    // A string literal that is logged without copying it, only pointer & length are stored (see LOG_STATIC() & LOG_SEPERATOR)
+    // @note consteval => only compiles for literals, a temporary buffer can't end up in the queue
+    struct static_text {
+
+        template<size_t N>
+        consteval explicit static_text(const char (&text)[N])
+            : text(text, N - 1) {}
+
+        std::string_view        text;
+    };
+
+    // One field of the logging context of a thread (see scoped_context). Immutable, all messages logged while it is active share it
+    struct context_node {
+        std::string             key;
+        std::string             value;
+        std::shared_ptr<const context_node> parent{};       // enclosing scope
+    };
+
     // Structure to represent the format of a log message
     // @struct message_format Encapsulates details for a log message
     // @param msg_sev The severity level of the message
     // @param file_name The name of the file where the log message originated
     // @param function_name The function name where the log message was generated
     // @param line The line number in the source file of the log message
-    // @param message The actual log message content
+    // @param message The actual log message content (moved in, never copied on the way to the worker)
+    // @param static_message Referenced string literal (see static_text), used instead of [message] if set. Use text() to get either
+    // @param timestamp The time the message was logged (used for all time tags)
+    // @param stack_trace Raw return addresses of the logging thread (init_options::stack_trace_depth), symbolized when formatted ($U)
+    // @param context Logging context of the calling thread (see scoped_context), only the pointer is shared, rendered by $W
+    // @param sequence Number of the message in the order it was logged ($V), set when it is enqueued. Messages written into the main file
+    //                 out of order (init_options::priority_lanes / synchronous_errors) can be sorted by it
     struct message_format {
 
-        message_format(const logger::severity msg_sev, const char* file_name, const char* function_name, const int line, std::thread::id thread_id, const std::string& message) 
-            : msg_sev(msg_sev), file_name(file_name), function_name(function_name), line(line), thread_id(thread_id), message(message) {};
+        message_format() = default;
 
-        const logger::severity  msg_sev;
-        const char*             file_name;
-        const char*             function_name;
-        const int               line;
-        const std::thread::id   thread_id;
-        const std::string       message;
+        message_format(const logger::severity msg_sev, const char* file_name, const char* function_name, const int line, std::thread::id thread_id, std::string message, const std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now()) 
+            : msg_sev(msg_sev), file_name(file_name), function_name(function_name), line(line), thread_id(thread_id), message(std::move(message)), timestamp(timestamp) {};
+
+        message_format(const logger::severity msg_sev, const char* file_name, const char* function_name, const int line, std::thread::id thread_id, const static_text message, const std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now()) 
+            : msg_sev(msg_sev), file_name(file_name), function_name(function_name), line(line), thread_id(thread_id), static_message(message.text), timestamp(timestamp) {};
+
+        std::string_view text() const { return (static_message.data() != nullptr) ? static_message : std::string_view(message); }
+
+        logger::severity        msg_sev = logger::severity::Trace;
+        const char*             file_name = "";
+        const char*             function_name = "";
+        int                     line = 0;
+        std::thread::id         thread_id{};
+        std::string             message = "";
+        std::string_view        static_message{};
+        std::chrono::system_clock::time_point timestamp{};
+        std::shared_ptr<const std::vector<void*>> stack_trace{};
+        std::shared_ptr<const context_node> context{};
+        u64                     sequence = 0;
+    };
+
+    // Header at the beginning of the sidecar index file (<main_log_file>.idx)
+    // @param magic Always "LOGIDX2"
+    // @param block_size Size of one indexed block in bytes (a block is closed at the first message boundary after this size)
+    struct index_header {
+        char                    magic[8];
+        u32                     block_size;
+        u32                     reserved;
+    };
+    constexpr const char        index_magic[8] = "LOGIDX2";
+
+    // One entry of the sidecar index, describing a block of the log file. The [record_count] records of the block directly follow it in the index file
+    // @param begin_offset Byte offset of the first message in the block
+    // @param end_offset Byte offset after the last message in the block
+    // @param min_timestamp Time of the oldest message in the block (milliseconds since epoch)
+    // @param max_timestamp Time of the newest message in the block (milliseconds since epoch)
+    // @note The messages of a block are not always in time order (priority_lanes, synchronous_errors, backtrace), so the timestamps are bounds, not the first & last message
+    // @param thread_mask 64-bit bloom filter of the threads that logged in the block (see index_thread_bit())
+    // @param severity_mask Bit N is set if the block contains a message with severity N
+    // @param record_count Number of [index_record]s (messages) of the block
+    struct index_entry {
+        u64                     begin_offset;
+        u64                     end_offset;
+        int64                   min_timestamp;
+        int64                   max_timestamp;
+        u64                     thread_mask;
+        u8                      severity_mask;
+        u8                      reserved[3];
+        u32                     record_count;
+    };
+
+    // One message of an indexed block, other output of the logger (e.g. "[LOGGER] ..." lines) between the messages has no record
+    // @param offset Byte offset of the message, relative to [index_entry::begin_offset]
+    // @param size Size of the formatted message in bytes
+    // @param time_offset Time of the message in milliseconds after [index_entry::min_timestamp]
+    // @param thread_bit Bit of the thread in [index_entry::thread_mask]
+    // @param severity Severity of the message
+    struct index_record {
+        u32                     offset;
+        u32                     size;
+        u32                     time_offset;
+        u8                      thread_bit;
+        u8                      severity;
+        u8                      reserved[2];
+    };
+
+    // Bit used in [index_entry::thread_mask] for a thread lable (FNV-1a hash, stable across builds)
+    inline u64 index_thread_bit(const std::string_view thread_lable) {
+
+        u64 hash = 14695981039346656037ull;
+        for (const char c : thread_lable)
+            hash = (hash ^ static_cast<u8>(c)) * 1099511628211ull;
+        return u64(1) << (hash % 64);
+    }
+
+    // What the socket sink (init_options::socket_path) sends for every log message
+    // @note formatted The message formatted like in the main file
+    // @note binary A [socket_binary_record] followed by file name, function name and message (nothing is formatted)
+    enum class socket_record_type : u8 {
+        formatted = 0,
+        binary,
+    };
+
+    // Frame of one batch sent to the socket sink, integers are in native byte order (the collector runs on the same host)
+    // The header is followed by [payload_size] bytes with [record_count] records, every record is a u32 length followed by its content
+    // @param magic Always [socket_batch_magic]
+    struct socket_batch_header {
+        u32                     magic;
+        u32                     payload_size;
+        u32                     record_count;
+        u8                      record_type;            // socket_record_type
+        u8                      reserved[3];
+    };
+    constexpr u32               socket_batch_magic = 0x32424C4C;       // "LLB2"
+
+    // @param timestamp Time of the log call (micro-seconds since epoch)
+    // @param thread_id std::hash of the std::thread::id
+    // @param sequence See message_format::sequence
+    struct socket_binary_record {
+        int64                   timestamp;
+        u64                     thread_id;
+        u64                     sequence;
+        u32                     line;
+        u32                     message_size;
+        u16                     file_name_size;
+        u16                     function_name_size;
+        u8                      severity;
+        u8                      reserved[3];
+    };
+
+    // When the worker forces written log messages from the OS cache onto the disk
+    // @note none Leave it to the OS (fastest, messages of the last seconds can be lost on a power failure)
+    // @note fdatasync_per_batch fdatasync() after every batch of messages
+    // @note fsync_on_error fsync() after every Error or Fatal message
+    // @note fsync_interval fsync() at most every [init_options::fsync_interval_ms] if something was written
+    enum class durability : u8 {
+        none = 0,
+        fdatasync_per_batch,
+        fsync_on_error,
+        fsync_interval,
+    };
+
+    // How the worker waits for new messages when the queue is empty
+    // @note block Sleep on a condition variable right away (lowest CPU usage)
+    // @note spin_then_park Spin for [init_options::spin_budget] iterations, then sleep on the condition variable
+    // @note yield Never sleep, call std::this_thread::yield() between checks
+    // @note busy_poll Never sleep or yield (lowest latency, occupies a whole core, use together with [init_options::worker_cpu])
+    // @note Producers only wake the worker (futex syscall) if it is actually sleeping
+    enum class wait_strategy : u8 {
+        block = 0,
+        spin_then_park,
+        yield,
+        busy_poll,
+    };
+
+    // Streaming compression of the main log file
+    // @note gzip Needs zlib (LOGGER_USE_ZLIB), the file can be read with zcat while it is written
+    // @note zstd Needs libzstd (LOGGER_USE_ZSTD), the file can be read with zstdcat while it is written. Falls back to gzip if not available
+    enum class compression : u8 {
+        none = 0,
+        gzip,
+        zstd,
+    };
+
+    // Optional settings for init(), the defaults keep the classic behavior (one log file written by one worker thread)
+    // @param index_block_size_kb Write a sidecar index (<main_log_file_name>.idx) with one entry every N KB of log output (max 1 GB), 0 = disabled.
+    //                            Every entry is followed by a 16 byte record per message (offset, size, time, thread, severity).
+    //                            The index is used by the [log_query] tool to jump straight to matching blocks and messages
+    // @param per_thread_files Every thread with a registered lable writes into its own file [log_dir]/thread_<lable>.log on the calling thread,
+    //                         without the queue or any shared lock. Threads without a lable still use the main log file.
+    //                         Lables registered bevor init() (or kept over a shutdown()) get their file in init()
+    //                         Use the [log_merge] tool to get a single view ordered by time
+    // @param config_file Optional config file that is loaded in init() and reloaded whenever it changes (inotify, Linux only).
+    //                    Changes are applied by the worker between two batches, logging is never paused.
+    //                    Lines are "key = value", '#' starts a comment. Keys:
+    //                      format = [$B$T:$J  $L$X  $Q  $I $F:$G$E] $C$Z      same tags as set_format(), may be quoted to keep spaces
+    //                      console = on | off                                  same as [log_to_console]
+    //                      flush = none | batch                                flush the main file after every batch
+    //                      durability = none | batch | error | <N>ms            see [durability_mode], <N>ms => fsync_interval
+    //                      level = Info                                        runtime log level (Error & Fatal can't be disabled)
+    //                      level.file.<file name> = Trace                      level for one source file, e.g. level.file.main.cpp
+    //                      level.thread.<thread lable> = Debug                 level for one thread lable (takes priority over file levels)
+    // @param durability_mode When the worker syncs the main file to disk, see [durability]
+    // @param worker_wait_strategy See [wait_strategy], [spin_budget] is the number of spin iterations bevor parking for spin_then_park
+    // @param worker_cpu Pin the worker thread to this CPU core, -1 = no pinning (Linux only)
+    // @param worker_sched_priority 0 = normal scheduling, 1-99 = SCHED_FIFO with this priority (needs CAP_SYS_NICE, Linux only)
+    // @param formatter_threads Number of extra threads that format messages in parallel, 0 = the worker formats everything itself.
+    //                          The worker cuts the queue into chunks of [formatter_chunk_size] messages and still writes them
+    //                          in enqueue order, so the main file looks exactly the same as without formatter threads
+    // @param backtrace_size Keep the last N messages below [backtrace_level] in memory instead of writing them, 0 = disabled.
+    //                       They are stored unformatted and only written (framed by a "[LOGGER] backtrace" line) when a message
+    //                       at or above [backtrace_trigger] is logged or dump_backtrace() is called.
+    //                       DEBUG_BREAK/ASSERT log a Fatal message to the default instance and therefore always trigger it
+    // @param backtrace_per_thread Every thread keeps its own ring and a trigger only writes the ring of the triggering thread,
+    //                             otherwise all threads share one ring (guarded by a mutex)
+    // @param main_file_compression Compress the main log file, ".gz" or ".zst" is appended to [main_log_file_name].
+    //                              The worker compresses whole batches and adds a sync-flush point at least every [compression_flush_interval_ms]
+    //                              (and on every flush()), everything bevor a sync-flush point can already be decompressed.
+    //                              The sidecar index is disabled for compressed files, per-thread files are not compressed
+    // @param compression_level 0 = default of the compressor (gzip: 6, zstd: 3)
+    // @param socket_path Additionally stream all messages of the main file to a Unix-domain socket (e.g. a log collector daemon), empty = disabled.
+    //                    The worker sends one frame per batch (see [socket_batch_header]) without ever blocking, producers never touch the socket.
+    //                    If the collector is not reachable the worker reconnects every [socket_reconnect_ms] and keeps up to
+    //                    [socket_buffer_kb] of frames, the oldest frames are dropped beyond that. Use the [log_collector] tool for testing
+    // @param shared_file Open the main file with O_APPEND and write it with write() instead of std::ofstream, so multiple processes
+    //                    (e.g. forked workers) can log into the same file. Every write() contains only whole records and is at most
+    //                    [shared_write_limit] bytes (a single larger record is written alone), so lines never tear or interleave.
+    //                    Compression and the sidecar index are not available for shared files. Use the $R tag to tell the processes apart
+    // @param stack_trace_depth Capture up to N return addresses (backtrace()) on the logging thread for messages at or above [stack_trace_level], 0 = disabled.
+    //                          N counts only frames outside the logger. Only the raw addresses are stored (a few micro-s), the symbol names are resolved
+    //                          (dladdr + demangling) and the leading frames of the logger are skipped when the message is formatted by the worker.
+    //                          Use the $U tag to print the trace, one frame per line:
+    //                            #0  app::load_config(std::string const&)+0x4c  [./main+0x1a2b4]
+    //                          Frames of executables need -rdynamic for a name, [module+offset] can always be resolved with addr2line (Linux only)
+    // @param priority_lanes Queue messages in three lanes (Error/Fatal, Info/Warn, Trace/Debug), the worker always drains the highest lane first,
+    //                       so an Error doesn't wait behind a backlog of Trace messages. Commands (set_format(), flush(), ...) still apply
+    //                       at their position. The main file is no longer in logging order, use the $V tag (or socket_binary_record::sequence)
+    // @param synchronous_errors Format and write Error/Fatal messages on the calling thread and flush them to the OS right away (fsync too
+    //                           if [durability_mode] is not none), instead of queuing them. They use the format the worker currently
+    //                           applies (a set_format() still waiting in the queue is ignored) and are sent to the socket sink right away
+    // @param profile_call_sites Count messages, bytes and formatting time of every LOG() call site (file & line), see get_call_site_stats().
+    //                           Counted where the message is formatted (worker, formatter threads or the owner of a per-thread file), producers are not slowed down
+    // @param call_site_report_interval_ms Let the worker write the top [call_site_report_count] call sites by volume into the main file
+    //                                     at most every N ms (and at shutdown), 0 = only on request with get_call_site_stats()
+    // @note After fork() the child gets its own worker (and formatter/config threads) with an empty queue, messages queued in the parent
+    //       bevor the fork are only written by the parent. Without [shared_file] both processes write through their own buffers into the same file.
+    //       A compressed or indexed main file can't be continued by two processes, the child logs into its own file <name>.<pid>.<extension>
+    //       (e.g. general.4711.log.gz) with its own index
+    struct init_options {
+        u32                     index_block_size_kb = 0;
+        bool                    per_thread_files = false;
+        std::filesystem::path   config_file = "";
+        durability              durability_mode = durability::none;
+        u32                     fsync_interval_ms = 1000;
+        wait_strategy           worker_wait_strategy = wait_strategy::block;
+        u32                     spin_budget = 20000;
+        int                     worker_cpu = -1;
+        int                     worker_sched_priority = 0;
+        u32                     formatter_threads = 0;
+        u32                     formatter_chunk_size = 256;
+        u32                     backtrace_size = 0;
+        severity                backtrace_level = severity::Info;
+        severity                backtrace_trigger = severity::Error;
+        bool                    backtrace_per_thread = false;
+        compression             main_file_compression = compression::none;
+        int                     compression_level = 0;
+        u32                     compression_flush_interval_ms = 1000;
+        std::filesystem::path   socket_path = "";
+        socket_record_type      socket_record = socket_record_type::formatted;
+        u32                     socket_buffer_kb = 4096;
+        u32                     socket_reconnect_ms = 1000;
+        bool                    shared_file = false;
+        u32                     shared_write_limit = 4096;
+        u32                     stack_trace_depth = 0;
+        severity                stack_trace_level = severity::Fatal;
+        bool                    priority_lanes = false;
+        bool                    synchronous_errors = false;
+        bool                    profile_call_sites = false;
+        u32                     call_site_report_interval_ms = 0;
+        u32                     call_site_report_count = 10;
+    };
+
+    // Performance counters of a logger instance, averages are in micro-seconds
+    // @note Only the counters of the TIME_*_PERFORMANCE switches enabled in logger.cpp are filled
+    // @note The worker updates them without synchronization, call flush() first to get exact values
+    // @param end_to_end_* Time from the log call until the message was written into the main file
+    // @param compression_* Bytes in & out of the compressor (init_options::main_file_compression), ratio = input / output.
+    //                      counter/average_compression_time are the calls into the compressor (one per 64 KB or sync-flush point)
+    // @param socket_* Records delivered to the socket sink and records dropped because its buffer was full
+    struct stats {
+        u32                     formatting_counter = 0;
+        f32                     average_formatting_time = 0;
+        u32                     queue_adding_counter = 0;
+        f32                     average_queue_adding_time = 0;
+        u32                     writing_to_file_counter = 0;
+        f32                     average_writing_to_file_time = 0;
+        u32                     cout_counter = 0;
+        f32                     average_cout_time = 0;
+        u32                     end_to_end_counter = 0;
+        f32                     average_end_to_end_latency = 0;
+        f32                     max_end_to_end_latency = 0;
+        u64                     compression_input_bytes = 0;
+        u64                     compression_output_bytes = 0;
+        f32                     compression_ratio = 0;
+        u32                     compression_counter = 0;
+        f32                     average_compression_time = 0;
+        u64                     socket_sent_records = 0;
+        u64                     socket_dropped_records = 0;
+        u64                     console_dropped_messages = 0;
+    };
+
+    // Volume of one LOG() call site (init_options::profile_call_sites)
+    // @param bytes Size of the formatted messages
+    // @param average_formatting_time in micro-seconds
+    struct call_site_stats {
+        std::string             file_name;
+        std::string             function_name;
+        int                     line;
+        u64                     messages;
+        u64                     bytes;
+        f32                     average_formatting_time;
     };
 
     // Initalize the logging system
     // @param format The iital log message foemat
     // @param log_to_console should the log message be written to std::cout?
     // @param log_dir the directory that will contain all log files
-    // @ main_log_file_name name of the central log_file (the thread that runs logger::init())
+    // @ main_log_file_name name of the central log_file (all threads without an own file, see init_options::per_thread_files)
     // @param use_append_mode Should the system write over the existing log file or append to it
-    bool init(const std::string& format, const bool log_to_console = false, const std::filesystem::path log_dir = "./logs", const std::string& main_log_file_name = "general.log", const bool use_append_mode = false);
+    // @param options Optional settings, e.g. init(format, false, "./logs", "general.log", false, { .index_block_size_kb = 64 })
+    bool init(const std::string& format, const bool log_to_console = false, const std::filesystem::path log_dir = "./logs", const std::string& main_log_file_name = "general.log", const bool use_append_mode = false, const init_options& options = {});
 
     // shutdown the logging system
     void shutdown();
@@ -84,11 +388,15 @@ namespace logger {
     // @param $D data day                dd
     //
     // @param $M thread                  Thread_id: 137575225550656 or a lable if provided
+    // @param $R process id              4711 (the id of the child after a fork)
     // @param $F function name           application::main, math::foo
     // @param $P only function name      main, foo
     // @param $A file name               /home/workspace/test_cpp/src/main.cpp  /home/workspace/test_cpp/src/project.cpp
     // @param $I only file name          main.cpp
     // @param $G line                    1, 42
+    // @param $W context                 req=4711 tenant=acme, the fields of all active scoped_context of the logging thread
+    // @param $V sequence number         0, 1, 2 ... order in which the messages were logged (see init_options::priority_lanes)
+    // @param $U stack trace             one line per frame, only for messages with a captured trace (init_options::stack_trace_depth)
     //
     // @param $L log-level               add used log severity: [TRACE], [DEBUG] ... [FATAL]
     // @param $X alignment               adds space for "INFO" & "WARN"
@@ -106,6 +414,24 @@ namespace logger {
     // get the currently used log-message format
     const std::string get_format();
 
+    // Blocks until every message logged bevor this call is written and synced to disk (main file and index).
+    // Per-thread files are flushed to the OS
+    void flush();
+
+    // Same as flush(), but returns immediately. The future is ready when the barrier reached the disk
+    std::future<void> flush_async();
+
+    // Performance counters of the logger, see [stats]
+    stats get_stats();
+
+    // Write the messages kept in the backtrace ring (init_options::backtrace_size) now, without a trigger message.
+    // With backtrace_per_thread only the ring of the calling thread is written
+    void dump_backtrace();
+
+    // Counters of all LOG() call sites since init(), sorted by bytes (init_options::profile_call_sites, empty otherwise)
+    // @param max_count Only return the N noisiest call sites, 0 = all
+    std::vector<call_site_stats> get_call_site_stats(const u32 max_count = 0);
+
     // Registers a label for a specific thread, allowing for easier identification in logs.
     // If a label is already registered for the given thread ID, it will be overridden with the new label.
     // @param thread_label The label to be associated with the thread.
@@ -121,7 +447,125 @@ namespace logger {
 
     // // THIS SHOULD NEVER BE DIRECTLY CALLED
     // // @note empty log messages will be ignored
-    void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const std::string& message);
+    // // @note [message] is moved through to the worker, pass an rvalue (e.g. std::move(oss).str()) to avoid a copy
+    void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, std::string message);
+    void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const static_text message);
+
+    // An independent logger with its own queue, worker thread, log file, format and thread lables.
+    // Use it to isolate subsystems from each other, log into it with LOG_TO(instance, severity, message)
+    // @note The free functions above (init, shutdown, set_format, ...) and LOG() route to default_instance()
+    // @note The destructor shuts the instance down if that was not done already
+    class instance {
+    public:
+
+        instance();
+
+        // Creates the instance and calls init() with the given arguments
+        instance(const std::string& format, const bool log_to_console = false, const std::filesystem::path log_dir = "./logs", const std::string& main_log_file_name = "general.log", const bool use_append_mode = false, const init_options& options = {});
+
+        ~instance();
+
+        instance(const instance&) = delete;
+        instance& operator=(const instance&) = delete;
+
+        // See logger::init(), the [log_dir]/[main_log_file_name] combination should be unique per instance
+        bool init(const std::string& format, const bool log_to_console = false, const std::filesystem::path log_dir = "./logs", const std::string& main_log_file_name = "general.log", const bool use_append_mode = false, const init_options& options = {});
+        void shutdown();
+        bool is_initialized() const;
+
+        void set_format(const std::string& new_format);
+        void use_previous_format();
+        const std::string get_format();
+
+        void flush();
+        std::future<void> flush_async();
+        stats get_stats();
+        void dump_backtrace();
+        std::vector<call_site_stats> get_call_site_stats(const u32 max_count = 0);
+
+        void register_label_for_thread(const std::string& thread_lable, std::thread::id thread_id = std::this_thread::get_id());
+        void unregister_label_for_thread(std::thread::id thread_id = std::this_thread::get_id());
+
+        // THIS SHOULD NEVER BE DIRECTLY CALLED, use LOG_TO()
+        void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, std::string message);
+        void log_msg(const severity msg_sev , const char* file_name, const char* function_name, const int line, const std::thread::id thread_id, const static_text message);
+
+    private:
+
+        struct impl;
+        std::unique_ptr<impl>   m_impl;
+    };
+
+    // The instance used by the free functions and the LOG() macros
+    instance& default_instance();
+
+    // The logging context of a thread, captured by capture_context() to continue it on another thread
+    struct context_snapshot {
+        std::shared_ptr<const context_node> node{};
+    };
+
+    // @return the logging context of the calling thread, e.g. to hand it to a task that runs on a thread pool
+    context_snapshot capture_context();
+
+    // Adds a field to the logging context of the calling thread until it goes out of scope. Every message logged by the thread meanwhile
+    // references the context (no string is copied or formatted per message), the $W tag renders it. Scopes can be nested
+    // @note { logger::scoped_context request("req", request_id); LOG(Info, "accepted"); }   =>  "req=4711 accepted" with format "$W $C$Z"
+    // @note Scopes have to end in reverse order on the thread that created them
+    class scoped_context {
+    public:
+
+        scoped_context(std::string key, std::string value);
+
+        // the value is converted to a string once, when the scope begins
+        template<typename T>
+        scoped_context(std::string key, const T& value)
+            : scoped_context(std::move(key), to_string(value)) {}
+
+        // continue a captured context on this thread (thread pool handoff), the previous context is restored at the end of the scope
+        explicit scoped_context(const context_snapshot& snapshot);
+
+        ~scoped_context();
+
+        scoped_context(const scoped_context&) = delete;
+        scoped_context& operator=(const scoped_context&) = delete;
+
+    private:
+
+        template<typename T>
+        static std::string to_string(const T& value) {
+
+            std::ostringstream stream;
+            stream << value;
+            return std::move(stream).str();
+        }
+
+        std::shared_ptr<const context_node> m_previous;
+    };
+
+    // Runtime switch for the success messages of ASSERT() & VALIDATE() (only if ENABLE_LOGGING_OF_CHECK_SUCCESS is set), off by default
+    inline std::atomic<bool>    check_success_logging = false;
+
+    // Pass counter of one ASSERT() / VALIDATE() call site (ENABLE_CHECK_PASS_COUNTERS), registered on its first pass
+    // THIS SHOULD NEVER BE DIRECTLY USED, the macros create one static instance per call site
+    struct check_site {
+        check_site(const char* file_name, const int line, const char* expression);
+
+        const char*             file_name;
+        const int               line;
+        const char*             expression;
+        std::atomic<u64>        passes = 0;
+        check_site*             next = nullptr;             // list of all registered call sites
+    };
+
+    struct check_site_stats {
+        std::string             file_name;
+        int                     line;
+        std::string             expression;
+        u64                     passes;
+    };
+
+    // Pass counters of all ASSERT() / VALIDATE() call sites that passed at least once, sorted by passes (empty if ENABLE_CHECK_PASS_COUNTERS is 0)
+    std::vector<check_site_stats> get_check_stats();
 }
 
 
@@ -145,9 +589,10 @@ private:
 // @param message The custom message to include in the debug break exception
 // @note DEBUG_BREAK Triggers a debug break exception with a formatted message
 // @note Constructs a detailed message containing the file name, function name, and line number
-#define DEBUG_BREAK(message)             { std::ostringstream oss; oss << "DEBUG BREAK [file: " << __FILE__ << ", function: " << __FUNCTION__ << ", line: " << __LINE__ << "] => "<< message; throw debug_break_exception(oss.str()); }
+// @note The Fatal message also writes the backtrace ring of the default instance (init_options::backtrace_size)
+#define DEBUG_BREAK(message)             { std::ostringstream oss; oss << "DEBUG BREAK [file: " << __FILE__ << ", function: " << __FUNCTION__ << ", line: " << __LINE__ << "] => "<< message; throw debug_break_exception(std::move(oss).str()); }
 
-// #define DEBUG_BREAK(message)                { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Fatal, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), oss.str()); std::abort(); }
+// #define DEBUG_BREAK(message)                { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Fatal, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); std::abort(); }
 
 
 // This define enables the diffrent log levels (FATAL & ERROR are always on)
@@ -161,42 +606,81 @@ private:
 #define ENABLED_LOGGING_OF_ASSERTS          1
 #define ENABLE_LOGGING_OF_VALIDATION        1
 
+// Success path of ASSERT() & VALIDATE(). A passing check only costs the branch unless one of these is enabled (e.g. -DENABLE_CHECK_PASS_COUNTERS=1)
+//  ENABLE_LOGGING_OF_CHECK_SUCCESS     log [successMsg] as Trace, additionally needs logger::check_success_logging = true at runtime
+//  ENABLE_CHECK_PASS_COUNTERS          count the passes of every call site (relaxed atomic increment), see logger::get_check_stats()
+#ifndef ENABLE_LOGGING_OF_CHECK_SUCCESS
+    #define ENABLE_LOGGING_OF_CHECK_SUCCESS 0
+#endif
+#ifndef ENABLE_CHECK_PASS_COUNTERS
+    #define ENABLE_CHECK_PASS_COUNTERS      0
+#endif
+
 //  =================================================================================== Logger  ===================================================================================
 
 // I use std::ostringstream here instead of lamdas because the logger runs async and I want to capture the values in pointers/refs in the moment the macro is called
 // This costs some performance but is more useful when debugging an application
 
 // always enabled
-#define LOG_Fatal(message)                  { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Fatal, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), oss.str()); }
+#define LOG_Fatal(message)                  { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Fatal, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
 
-#define LOG_Error(message)                  { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Error, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), oss.str()); }
+#define LOG_Error(message)                  { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Error, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
 
 #if LOG_LEVEL_ENABLED > 0
-    #define LOG_Warn(message)               { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Warn, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), oss.str()); }
+    #define LOG_Warn(message)               { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Warn, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
 #else
     #define LOG_Warn(message)               { }
 #endif
 
 #if LOG_LEVEL_ENABLED > 1
-    #define LOG_Info(message)               { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Info, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), oss.str()); }
+    #define LOG_Info(message)               { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Info, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
 #else
     #define LOG_Info(message)               { }
 #endif
 
 #if LOG_LEVEL_ENABLED > 2
-    #define LOG_Debug(message)              { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Debug, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), oss.str()); }
+    #define LOG_Debug(message)              { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Debug, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
 #else
     #define LOG_Debug(message)              { }
 #endif
 
 #if LOG_LEVEL_ENABLED > 3
-    #define LOG_Trace(message)              { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Trace, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), oss.str()); }
-    #define LOG_SEPERATOR                   { logger::log_msg(logger::severity::Trace, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), "-------------------------------------------------------------"); }
+    #define LOG_Trace(message)              { std::ostringstream oss; oss << message; logger::log_msg(logger::severity::Trace, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
+    #define LOG_SEPERATOR                   { logger::log_msg(logger::severity::Trace, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), logger::static_text("-------------------------------------------------------------")); }
 #else
     #define LOG_Trace(message)              { }
     #define LOG_SEPERATOR                   { }
 #endif
 
+// Same as the macros above, but for a specific logger::instance
+#define LOG_TO_Fatal(instance, message)     { std::ostringstream oss; oss << message; (instance).log_msg(logger::severity::Fatal, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
+
+#define LOG_TO_Error(instance, message)     { std::ostringstream oss; oss << message; (instance).log_msg(logger::severity::Error, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
+
+#if LOG_LEVEL_ENABLED > 0
+    #define LOG_TO_Warn(instance, message)  { std::ostringstream oss; oss << message; (instance).log_msg(logger::severity::Warn, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
+#else
+    #define LOG_TO_Warn(instance, message)  { }
+#endif
+
+#if LOG_LEVEL_ENABLED > 1
+    #define LOG_TO_Info(instance, message)  { std::ostringstream oss; oss << message; (instance).log_msg(logger::severity::Info, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
+#else
+    #define LOG_TO_Info(instance, message)  { }
+#endif
+
+#if LOG_LEVEL_ENABLED > 2
+    #define LOG_TO_Debug(instance, message) { std::ostringstream oss; oss << message; (instance).log_msg(logger::severity::Debug, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
+#else
+    #define LOG_TO_Debug(instance, message) { }
+#endif
+
+#if LOG_LEVEL_ENABLED > 3
+    #define LOG_TO_Trace(instance, message) { std::ostringstream oss; oss << message; (instance).log_msg(logger::severity::Trace, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), std::move(oss).str()); }
+#else
+    #define LOG_TO_Trace(instance, message) { }
+#endif
+
 namespace logger {
     std::mutex& get_timing_mutex();
 }
@@ -211,48 +695,75 @@ namespace logger {
 // #define LOG(severity, message)              { std::lock_guard<std::mutex> timing_lock(logger::get_timing_mutex()); START_DEBUG_TIMER(main_thread) LOG_##severity(message) END_DEBUG_TIMER(main_thread) }
 #define LOG(severity, message)              LOG_##severity(message)
 
+// Log a string literal without formatting or copying it (no heap allocation on the calling thread)
+// @param level The severity level of the log (e.g., Trace, Debug, Info, Warn, Error, Fatal), respects LOG_LEVEL_ENABLED like LOG()
+// @param text A string literal, anything else doesn't compile
+// @note LOG_STATIC(Debug, "entering render loop");
+#define LOG_STATIC(level, text)             { if constexpr (static_cast<int>(logger::severity::level) >= 4 - LOG_LEVEL_ENABLED) logger::log_msg(logger::severity::level, __FILE__, __FUNCTION__, __LINE__, std::this_thread::get_id(), logger::static_text(text)); }
+
+// Logging macro for a specific logger::instance, see LOG()
+// @param instance The logger::instance that should receive the message
+// @note LOG_TO(network_logger, Warn, "Connection lost, retrying in " << delay << "ms");
+#define LOG_TO(instance, severity, message) LOG_TO_##severity(instance, message)
+
 
 #define LOG_INIT()							LOG(Trace, "init");
 #define LOG_SHUTDOWN()						LOG(Trace, "shutdown");
 
 // ---------------------------------------------------------------------------  Assertion & Validation  ---------------------------------------------------------------------------
 
+#if ENABLE_CHECK_PASS_COUNTERS
+    #define CHECK_COUNT_PASS(expr_string)                                   { static logger::check_site loc_check_site(__FILE__, __LINE__, expr_string); loc_check_site.passes.fetch_add(1, std::memory_order_relaxed); }
+#else
+    #define CHECK_COUNT_PASS(expr_string)                                   { }
+#endif
+
+#if ENABLE_LOGGING_OF_CHECK_SUCCESS
+    #define CHECK_PASSED(expr_string, successMsg)                           { CHECK_COUNT_PASS(expr_string) if (logger::check_success_logging.load(std::memory_order_relaxed)) LOG(Trace, successMsg) }
+#else
+    #define CHECK_PASSED(expr_string, successMsg)                           CHECK_COUNT_PASS(expr_string)
+#endif
+
 #if ENABLED_LOGGING_OF_ASSERTS
     #define ASSERT(expr, successMsg, failureMsg)							\
-                    if (expr) 												\
-                        LOG(Trace, successMsg)							    \
+                    if (expr) [[likely]]									\
+                        CHECK_PASSED(#expr, successMsg)					    \
                     else {												    \
                         LOG(Fatal, failureMsg)						        \
                         DEBUG_BREAK(failureMsg);							\
                     }
 
     #define ASSERT_S(expr)													\
-                    if (!(expr)) {									        \
+                    if (expr) [[likely]]									\
+                        CHECK_COUNT_PASS(#expr)							    \
+                    else {									                \
                         LOG(Fatal, #expr)						            \
                         DEBUG_BREAK(#expr);     					        \
                     }
 #else
-    #define ASSERT(expr, successMsg, failureMsg)							if (!(expr)) { DEBUG_BREAK(failureMsg); }
-    #define ASSERT_S(expr)													if (!(expr)) { DEBUG_BREAK(#expr); }
+    #define ASSERT(expr, successMsg, failureMsg)							if (expr) [[likely]] CHECK_COUNT_PASS(#expr) else { DEBUG_BREAK(failureMsg); }
+    #define ASSERT_S(expr)													if (expr) [[likely]] CHECK_COUNT_PASS(#expr) else { DEBUG_BREAK(#expr); }
 #endif // ENABLED_LOGGING_OF_ASSERT
 
 
 #if ENABLE_LOGGING_OF_VALIDATION
     #define VALIDATE(expr, command, successMsg, failureMsg)			        \
-                    if (expr)                                               \
-                        LOG(Trace, successMsg)                              \
+                    if (expr) [[likely]]                                    \
+                        CHECK_PASSED(#expr, successMsg)                     \
                     else {												    \
                         LOG(Warn, failureMsg)							    \
                         command;										    \
                     }
 
     #define VALIDATE_S(expr, command)									    \
-                    if (!(expr)) {											\
+                    if (expr) [[likely]]									\
+                        CHECK_COUNT_PASS(#expr)							    \
+                    else {											        \
                         LOG(Warn, "Validation Failed: " << #expr)		    \
                         command;										    \
                     }
 #else
-    #define VALIDATE(expr, ReturnCommand, successMsg, failureMsg)			if (!(expr)) { ReturnCommand; }
-    #define VALIDATE_S(expr, ReturnCommand)						            if (!(expr)) { ReturnCommand; }
+    #define VALIDATE(expr, ReturnCommand, successMsg, failureMsg)			if (expr) [[likely]] CHECK_COUNT_PASS(#expr) else { ReturnCommand; }
+    #define VALIDATE_S(expr, ReturnCommand)						            if (expr) [[likely]] CHECK_COUNT_PASS(#expr) else { ReturnCommand; }
 
 #endif // ENABLE_LOGGING_OF_VALIDATION
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "util.h"
+#include "logger.h"
+
+// Benchmark of the startup time of a process that uses the logger
+// The benchmark starts itself [run_count] times, every child measures from the moment the parent spawned it until its first message
+// is in the log file (logger::flush() returned). This includes exec & dynamic linking, so it also shows the cost of the linked libraries
+// Reported (average / min / max over all children):
+//  start:  spawn until main() is entered
+//  init:   logger::init()
+//  first:  first LOG() until it is written and synced (logger::flush())
+//  total:  spawn until the first message is written
+//
+// usage: logger_startup_benchmark [run_count]
+
+extern char** environ;
+
+namespace {
+
+    constexpr u32                                           default_run_count = 50;
+    constexpr std::string_view                              child_flag = "--child";
+    constexpr std::string_view                              result_prefix = "startup_result ";
+
+    struct startup_result {
+        f64                                                 start = 0;                  // micro-s
+        f64                                                 init = 0;
+        f64                                                 first = 0;
+        f64                                                 total = 0;
+    };
+
+    // steady_clock is CLOCK_MONOTONIC, so the time points of parent and child are comparable
+    int64 now_ns() {
+
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int run_child(const int64 spawn_time) {
+
+        const int64 main_entered = now_ns();
+        logger::init("[$T:$J  $L$X  $I:$G] $C$Z", false, "./logs", "startup_benchmark.log", false);
+        const int64 init_done = now_ns();
+        LOG(Info, "first message")
+        logger::flush();
+        const int64 first_written = now_ns();
+
+        // written bevor shutdown(), the performance report of the logger follows on std::cout
+        std::cout << result_prefix << (main_entered - spawn_time) / 1000.0 << " " << (init_done - main_entered) / 1000.0 << " "
+                  << (first_written - init_done) / 1000.0 << " " << (first_written - spawn_time) / 1000.0 << std::endl;
+        logger::shutdown();
+        return 0;
+    }
+
+    // @return false if the child couldn't be started or didn't report a result
+    bool spawn_child(const char* executable, startup_result& result) {
+
+        int output_pipe[2];
+        if (pipe(output_pipe) != 0)
+            return false;
+
+        posix_spawn_file_actions_t file_actions;
+        posix_spawn_file_actions_init(&file_actions);
+        posix_spawn_file_actions_adddup2(&file_actions, output_pipe[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&file_actions, output_pipe[0]);
+
+        const std::string spawn_time = std::to_string(now_ns());
+        char* const argv[] = { const_cast<char*>(executable), const_cast<char*>(child_flag.data()), const_cast<char*>(spawn_time.c_str()), nullptr };
+        pid_t child = -1;
+        const int spawn_error = posix_spawn(&child, executable, &file_actions, nullptr, argv, environ);
+        posix_spawn_file_actions_destroy(&file_actions);
+        close(output_pipe[1]);
+
+        std::string output;
+        char buffer[4096];
+        for (ssize_t received = 0; spawn_error == 0 && (received = read(output_pipe[0], buffer, sizeof(buffer))) > 0; )
+            output.append(buffer, static_cast<size_t>(received));
+        close(output_pipe[0]);
+
+        if (spawn_error != 0)
+            return false;
+        waitpid(child, nullptr, 0);
+
+        const size_t begin = output.find(result_prefix);
+        if (begin == std::string::npos)
+            return false;
+
+        std::istringstream line(output.substr(begin + result_prefix.size()));
+        return static_cast<bool>(line >> result.start >> result.init >> result.first >> result.total);
+    }
+
+    void print_row(std::ostringstream& report, const char* name, const std::vector<startup_result>& results, f64 startup_result::* field) {
+
+        f64 sum = 0;
+        f64 min = results.front().*field;
+        f64 max = min;
+        for (const startup_result& result : results) {
+            sum += result.*field;
+            min = std::min(min, result.*field);
+            max = std::max(max, result.*field);
+        }
+
+        report << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+               << std::setw(16) << sum / results.size() << std::setw(16) << min << std::setw(16) << max << "\n";
+    }
+
+}
+
+int main(int argc, char** argv) {
+
+    if (argc == 3 && argv[1] == child_flag)
+        return run_child(std::stoll(argv[2]));
+
+    const u32 run_count = (argc > 1) ? static_cast<u32>(std::stoul(argv[1])) : default_run_count;
+    std::vector<startup_result> results;
+    for (u32 x = 0; x < run_count; x++) {
+
+        startup_result result{};
+        if (!spawn_child("/proc/self/exe", result)) {
+            std::cerr << "FAILED to run child [" << x << "]" << std::endl;
+            return 1;
+        }
+        results.push_back(result);
+    }
+
+    std::ostringstream report;
+    report << std::left << std::setw(10) << "phase" << std::right << std::setw(16) << "avg [us]" << std::setw(16) << "min [us]" << std::setw(16) << "max [us]" << "\n";
+    print_row(report, "start", results, &startup_result::start);
+    print_row(report, "init", results, &startup_result::init);
+    print_row(report, "first", results, &startup_result::first);
+    print_row(report, "total", results, &startup_result::total);
+
+    std::cout << "\n" << report.str();
+    return 0;
+}
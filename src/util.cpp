@@ -7,9 +7,6 @@
 #include <string>
 //#include <ctime>
 
-#include <QApplication>
-#include <QFileDialog>
-#include <QString>
 #include <filesystem>
 
 namespace util {
@@ -49,29 +46,26 @@ namespace util {
         return loc_system_time;
     }
 
-    std::filesystem::path file_dialog(const std::string_view title, const std::vector<std::pair<std::string, std::string>>& filters) {
-        
-        int argc = 0;
-        char **argv = nullptr;
-        QApplication app(argc, argv);                                                                                                   // Create a QApplication instance
-
-        QString filterString;
-        for (auto& filter : filters) {                                                                                                  // Prepare the filter string for QFileDialog
-            
-            // Replace semicolons with spaces
-            std::string buffer = filter.second;
-            size_t pos = 0;
-            while ((pos = buffer.find(';', pos)) != std::string::npos) {                                                                // Replace ';' with ' ' 
-                buffer.replace(pos, 1, " ");
-                pos += 1;
-            }
-            
-            filterString += QString::fromStdString(filter.first) + " (" + QString::fromStdString(buffer) + ");;";
-        }
-        filterString.chop(2); // Remove the last ";;"
+    system_time get_system_time(const std::chrono::system_clock::time_point time_point) {
+
+        system_time loc_system_time{};
+        const std::time_t seconds = std::chrono::system_clock::to_time_t(time_point);
+        struct tm loc_tm{};
 
-        QString fileName = QFileDialog::getOpenFileName(nullptr, QString::fromUtf8(title.data()), QString(), filterString);             // Open the file dialog
-        return std::filesystem::path(fileName.toStdString());
+#if defined(__WIN32__)
+        localtime_s(&loc_tm, &seconds);
+#else
+        localtime_r(&seconds, &loc_tm);
+#endif
+        loc_system_time.year = static_cast<u16>(loc_tm.tm_year + 1900);
+        loc_system_time.month = static_cast<u8>(loc_tm.tm_mon + 1);
+        loc_system_time.day = static_cast<u8>(loc_tm.tm_mday);
+        loc_system_time.day_of_week = static_cast<u8>(loc_tm.tm_wday);
+        loc_system_time.hour = static_cast<u8>(loc_tm.tm_hour);
+        loc_system_time.minute = static_cast<u8>(loc_tm.tm_min);
+        loc_system_time.secund = static_cast<u8>(loc_tm.tm_sec);
+        loc_system_time.millisecends = static_cast<u16>(std::chrono::duration_cast<std::chrono::milliseconds>(time_point.time_since_epoch()).count() % 1000);
+        return loc_system_time;
     }
 
     f32 stopwatch::stop() {
@@ -61,12 +61,10 @@ namespace util {
 
     system_time get_system_time();
 
-    const std::vector<std::pair<std::string, std::string>> default_filters = {
-        {"All Files", "*.*"},
-        {"C++ Files", "*.cpp *.h *.hpp"},
-        {"Text Files", "*.txt"},
-    };
-    std::filesystem::path file_dialog(const std::string_view title = "Open", const std::vector<std::pair<std::string, std::string>>& filters = default_filters);
+    // local time of [time_point] (thread safe)
+    system_time get_system_time(const std::chrono::system_clock::time_point time_point);
+
+    // file_dialog() is in file_dialog.h (needs Qt5, not part of the cpp_logger library)
 
 
     // @brief This is a lightweit stopwatch that is automaticlly started when creating an instance.